@@ -0,0 +1,296 @@
+#include "catalog_cache.hpp"
+#include "queries.hpp"
+#include "rows.hpp"
+
+#include <spdlog/spdlog.h>
+#include <sqlite3.h>
+
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <tuple>
+#include <utility>
+
+const CatalogPet* CatalogSnapshot::find(std::int64_t id) const {
+    auto it = by_id.find(id);
+    return it == by_id.end() ? nullptr : &pets[it->second];
+}
+
+std::string CatalogSnapshot::page(const std::vector<std::uint32_t>& list,
+                                  const std::optional<Cursor>& after, std::int64_t limit,
+                                  std::optional<Cursor>& next) const {
+    auto first = list.begin();
+    if (after) {
+        // Same ordering as SQL's (created_at, id) < (?, ?) on a DESC listing
+        first = std::partition_point(list.begin(), list.end(), [&](std::uint32_t i) {
+            auto& pet = pets[i];
+            return !(std::tie(pet.created_at, pet.id) < std::tie(after->key, after->id));
+        });
+    }
+    auto last = list.end();
+    if (limit >= 0 && last - first > limit) {
+        last = first + limit;
+        auto& tail = pets[*(last - 1)];
+        next = Cursor{tail.created_at, tail.id};
+    }
+    return json_array(list.data() + (first - list.begin()), list.data() + (last - list.begin()));
+}
+
+std::string CatalogSnapshot::query(const PetFilter& filter, const std::optional<Cursor>& after,
+                                   std::int64_t limit, std::optional<Cursor>& next) const {
+    if (filter.plain()) {
+        return page(available, after, limit, next);
+    }
+
+    auto bits = index.match(filter);
+    if (filter.category) {
+        dbr::columns::Bitmap in_category(bits.size(), 0);
+        if (auto it = by_category.find(*filter.category); it != by_category.end()) {
+            for (auto pos : it->second) {
+                in_category[pos / 64] |= 1ull << (pos % 64);
+            }
+        }
+        dbr::columns::keep_selected(in_category, bits);
+    }
+
+    // The page plus one lookahead row
+    std::size_t wanted = limit < 0 ? pets.size() : static_cast<std::size_t>(limit) + 1;
+    std::vector<std::uint32_t> rows;
+    auto take = [&](std::size_t row) {
+        rows.push_back(static_cast<std::uint32_t>(row));
+        return rows.size() < wanted;
+    };
+
+    if (filter.sort == PetSort::Newest) {
+        // Rows are in listing order already
+        std::size_t first = 0;
+        if (after) {
+            first = static_cast<std::size_t>(std::partition_point(pets.begin(), pets.end(), [&](const CatalogPet& pet) {
+                return !(std::tie(pet.created_at, pet.id) < std::tie(after->key, after->id));
+            }) - pets.begin());
+        }
+        dbr::columns::for_each_from(bits, first, take);
+    } else {
+        bool ascending = filter.sort == PetSort::PriceAsc;
+        auto key = [&](std::uint32_t row) { return std::pair(index.price(row), index.id(row)); };
+        std::optional<std::pair<double, std::int64_t>> from;
+        if (after) {
+            // The handler has checked that the key is a number
+            double price = 0;
+            std::from_chars(after->key.data(), after->key.data() + after->key.size(), price);
+            from.emplace(price, after->id);
+        }
+
+        if (dbr::columns::count(bits) * 16 <= pets.size()) {
+            // Few matches: sort only those
+            dbr::columns::for_each_from(bits, 0, [&](std::size_t row) {
+                auto k = key(static_cast<std::uint32_t>(row));
+                if (!from || (ascending ? k > *from : k < *from)) {
+                    rows.push_back(static_cast<std::uint32_t>(row));
+                }
+                return true;
+            });
+            auto before = [&](std::uint32_t a, std::uint32_t b) {
+                return ascending ? key(a) < key(b) : key(b) < key(a);
+            };
+            auto middle = rows.begin() + static_cast<std::ptrdiff_t>(std::min(wanted, rows.size()));
+            std::partial_sort(rows.begin(), middle, rows.end(), before);
+            rows.erase(middle, rows.end());
+        } else {
+            // Many matches: walk the price order, which reaches a page of
+            // selected rows after a few steps
+            auto& order = index.by_price();
+            auto start = order.begin();
+            if (from) {
+                start = std::partition_point(order.begin(), order.end(), [&](std::uint32_t row) {
+                    return ascending ? key(row) <= *from : key(row) < *from;
+                });
+            }
+            if (ascending) {
+                for (auto it = start; it != order.end(); ++it) {
+                    if (dbr::columns::selected(bits, *it) && !take(*it)) break;
+                }
+            } else {
+                for (auto it = from ? start : order.end(); it != order.begin();) {
+                    --it;
+                    if (dbr::columns::selected(bits, *it) && !take(*it)) break;
+                }
+            }
+        }
+    }
+
+    if (limit >= 0 && rows.size() > static_cast<std::size_t>(limit)) {
+        rows.resize(static_cast<std::size_t>(limit));
+        auto& tail = pets[rows.back()];
+        if (filter.sort == PetSort::Newest) {
+            next = Cursor{tail.created_at, tail.id};
+        } else {
+            char key[32];
+            std::snprintf(key, sizeof(key), "%.17g", index.price(rows.back()));
+            next = Cursor{key, tail.id};
+        }
+    }
+    return json_array(rows.data(), rows.data() + rows.size());
+}
+
+std::string CatalogSnapshot::facet_counts(const PetFilter& filter, const std::vector<std::int64_t>* hits) const {
+    PetFilter ranges = filter;
+    ranges.species.reset();
+    ranges.available.reset();
+    auto base = index.match(ranges);
+    if (hits) {
+        dbr::columns::Bitmap found(base.size(), 0);
+        for (auto id : *hits) {
+            if (auto it = by_id.find(id); it != by_id.end()) {
+                found[it->second / 64] |= 1ull << (it->second % 64);
+            }
+        }
+        dbr::columns::keep_selected(found, base);
+    }
+    return facets.counts(filter, base);
+}
+
+std::string CatalogSnapshot::json_array(const std::uint32_t* first, const std::uint32_t* last) const {
+    std::size_t size = 2;
+    for (auto it = first; it != last; ++it) {
+        size += pets[*it].json.size() + 1;
+    }
+    std::string body;
+    body.reserve(size);
+    body += '[';
+    for (auto it = first; it != last; ++it) {
+        if (it != first) body += ',';
+        body += pets[*it].json;
+    }
+    body += ']';
+    return body;
+}
+
+
+CatalogCache::CatalogCache(std::shared_ptr<dbr::db::ConnectionPool> db,
+                           std::shared_ptr<dbr::db::MemoryReplica> replica)
+    : db_(std::move(db)), replica_(std::move(replica)) { }
+
+bool CatalogCache::covers(std::string_view table) {
+    return table == "pets" || table == "categories" || table == "pet_categories";
+}
+
+dbr::db::Connection& CatalogCache::reader() {
+    return replica_ ? replica_->reader() : db_->reader();
+}
+
+void CatalogCache::invalidate() {
+    if (replica_) {
+        replica_->invalidate();
+    }
+    generation_.fetch_add(1, std::memory_order_acq_rel);
+    invalidations_.fetch_add(1, std::memory_order_relaxed);
+}
+
+CatalogStats CatalogCache::stats() const {
+    return {hits_.load(std::memory_order_relaxed), loads_.load(std::memory_order_relaxed),
+            invalidations_.load(std::memory_order_relaxed)};
+}
+
+std::optional<dbr::db::ReplicaStats> CatalogCache::replica_stats() const {
+    if (!replica_) {
+        return std::nullopt;
+    }
+    return replica_->stats();
+}
+
+std::shared_ptr<const CatalogSnapshot> CatalogCache::snapshot() {
+    auto snap = current_.load(std::memory_order_acquire);
+    if (snap && snap->generation == generation_.load(std::memory_order_acquire)) {
+        hits_.fetch_add(1, std::memory_order_relaxed);
+        return snap;
+    }
+
+    std::lock_guard lock(load_mutex_);
+    // The generation is read before the read transaction starts: a write
+    // committing during the load bumps it and makes this snapshot stale
+    std::uint64_t generation = generation_.load(std::memory_order_acquire);
+    snap = current_.load(std::memory_order_acquire);
+    if (snap && snap->generation == generation) {
+        return snap;
+    }
+    snap = load(generation);
+    if (snap) {
+        current_.store(snap, std::memory_order_release);
+    }
+    return snap;
+}
+
+std::shared_ptr<const CatalogSnapshot> CatalogCache::load(std::uint64_t generation) {
+    auto& conn = reader();
+    auto snap = std::make_shared<CatalogSnapshot>();
+    snap->generation = generation;
+
+    // One read transaction, so pets and their category links agree
+    sqlite3_exec(conn, "BEGIN", nullptr, nullptr, nullptr);
+    bool ok = false;
+    {
+        auto pets = conn.prepare(queries::catalog_pets);
+        auto links = conn.prepare(queries::catalog_pet_categories);
+        auto categories = conn.prepare(queries::categories);
+        if (pets && links && categories) {
+            int rc;
+            while ((rc = sqlite3_step(pets)) == SQLITE_ROW) {
+                auto row = PetMapper::read(pets);
+                auto pos = static_cast<std::uint32_t>(snap->pets.size());
+                auto& pet = snap->pets.emplace_back();
+                pet.id = row.id;
+                pet.available = row.available;
+                pet.created_at = row.created_at;
+                PetMapper::write_json(row, pet.json);
+                snap->by_id.emplace(pet.id, pos);
+                snap->facets.add_pet(pos, row.species, row.available);
+                // Column 4 is age, which may be NULL
+                snap->index.add(row.id, row.price,
+                                sqlite3_column_type(pets, 4) == SQLITE_NULL ? std::nullopt : std::optional(row.age),
+                                row.species, row.available);
+                if (pet.available) {
+                    snap->available.push_back(pos);
+                    snap->suggest.add(row.name, SuggestIndex::Kind::Name);
+                    snap->suggest.add(row.breed, SuggestIndex::Kind::Breed);
+                    snap->suggest.add(row.species, SuggestIndex::Kind::Species);
+                }
+            }
+            ok = rc == SQLITE_DONE;
+
+            while (ok && (rc = sqlite3_step(links)) == SQLITE_ROW) {
+                auto pet = snap->by_id.find(sqlite3_column_int64(links, 0));
+                if (pet != snap->by_id.end()) {
+                    auto name = reinterpret_cast<const char*>(sqlite3_column_text(links, 1));
+                    snap->by_category[name ? name : ""].push_back(pet->second);
+                }
+            }
+            ok = ok && rc == SQLITE_DONE;
+
+            snap->categories_json = "[";
+            while (ok && (rc = sqlite3_step(categories)) == SQLITE_ROW) {
+                if (snap->categories_json.size() > 1) snap->categories_json += ',';
+                CategoryMapper::write_json(categories.get(), snap->categories_json);
+            }
+            ok = ok && rc == SQLITE_DONE;
+            snap->categories_json += ']';
+        }
+    }
+    sqlite3_exec(conn, "COMMIT", nullptr, nullptr, nullptr);
+
+    if (!ok) {
+        spdlog::error("Loading the catalog failed: {}", sqlite3_errmsg(conn));
+        return nullptr;
+    }
+    // Links arrive in table order; listings are served in pet order
+    for (auto& [name, list] : snap->by_category) {
+        std::sort(list.begin(), list.end());
+        snap->facets.add_category(name, list);
+    }
+    snap->index.finish();
+    snap->suggest.finish();
+    snap->facets.finish();
+    loads_.fetch_add(1, std::memory_order_relaxed);
+    spdlog::debug("Loaded catalog snapshot {} ({} pets)", generation, snap->pets.size());
+    return snap;
+}
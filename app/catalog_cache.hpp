@@ -0,0 +1,113 @@
+#pragma once
+
+#include "engine/db_pool.hpp"
+#include "engine/db_replica.hpp"
+#include "cursor.hpp"
+#include "facet_index.hpp"
+#include "pet_index.hpp"
+#include "suggest_index.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+struct CatalogPet {
+    std::int64_t id = 0;
+    bool available = false;
+    std::string created_at;
+    std::string json;       // as served by /api/pets/{id}
+};
+
+// Immutable copy of the catalog. Readers hold it through a shared_ptr for
+// as long as they need it; a newer snapshot never modifies an older one.
+struct CatalogSnapshot {
+    std::uint64_t generation = 0;
+    std::vector<CatalogPet> pets;   // listing order: created_at DESC, id DESC
+    std::unordered_map<std::int64_t, std::uint32_t> by_id;
+    std::vector<std::uint32_t> available;   // positions in `pets`, listing order
+    std::unordered_map<std::string, std::vector<std::uint32_t>> by_category;   // all pets
+    PetIndex index;                         // rows are positions in `pets`
+    SuggestIndex suggest;                   // available pets only
+    FacetIndex facets;
+    std::string categories_json;
+
+    const CatalogPet* find(std::int64_t id) const;
+
+    // JSON array of up to `limit` (-1: all) pets of `list` following the
+    // keyset cursor `after`. Sets `next` if more pets follow the page.
+    std::string page(const std::vector<std::uint32_t>& list, const std::optional<Cursor>& after,
+                     std::int64_t limit, std::optional<Cursor>& next) const;
+
+    // Like page(), for the pets matching `filter` in the filter's order.
+    // Price-ordered pages are keyed on (price, id).
+    std::string query(const PetFilter& filter, const std::optional<Cursor>& after,
+                      std::int64_t limit, std::optional<Cursor>& next) const;
+
+    // FacetIndex::counts for the pets matching `filter`'s price and age
+    // ranges and, given search hits, only those pet ids
+    std::string facet_counts(const PetFilter& filter, const std::vector<std::int64_t>* hits) const;
+
+private:
+    std::string json_array(const std::uint32_t* first, const std::uint32_t* last) const;
+};
+
+struct CatalogStats {
+    std::uint64_t hits = 0;
+    std::uint64_t loads = 0;
+    std::uint64_t invalidations = 0;
+};
+
+// Read-through cache of pets, their categories and the category table.
+//
+// The current snapshot is published through an atomic shared_ptr (RCU
+// style): lookups are a pointer load plus a generation check, with no lock
+// and no SQLite call. Any committed write to a catalog table bumps the
+// generation (see ConnectionPool::on_change); the next reader then rebuilds
+// the snapshot from its own read connection while others wait for it.
+//
+// With a `replica` of the catalog tables, snapshots and all other catalog
+// queries read the in-memory copy instead of the database file.
+class CatalogCache {
+public:
+    explicit CatalogCache(std::shared_ptr<dbr::db::ConnectionPool> db,
+                          std::shared_ptr<dbr::db::MemoryReplica> replica = nullptr);
+    CatalogCache(const CatalogCache&) = delete;
+    CatalogCache& operator=(const CatalogCache&) = delete;
+
+    // Up-to-date snapshot, or nullptr if it cannot be loaded
+    std::shared_ptr<const CatalogSnapshot> snapshot();
+
+    // Marks the current snapshot (and the replica's image) stale
+    void invalidate();
+
+    // Connection for catalog queries the snapshot cannot answer (searches):
+    // the replica's if there is one, else the pool's reader
+    dbr::db::Connection& reader();
+
+    // True for the tables a snapshot is built from
+    static bool covers(std::string_view table);
+
+    CatalogStats stats() const;
+
+    // Sizes and load counters of the in-memory copy, if there is one
+    std::optional<dbr::db::ReplicaStats> replica_stats() const;
+
+private:
+    std::shared_ptr<const CatalogSnapshot> load(std::uint64_t generation);
+
+    std::shared_ptr<dbr::db::ConnectionPool> db_;
+    std::shared_ptr<dbr::db::MemoryReplica> replica_;
+    std::atomic<std::shared_ptr<const CatalogSnapshot>> current_;
+    std::atomic<std::uint64_t> generation_{1};
+    std::mutex load_mutex_;
+
+    std::atomic<std::uint64_t> hits_{0};
+    std::atomic<std::uint64_t> loads_{0};
+    std::atomic<std::uint64_t> invalidations_{0};
+};
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+// Opaque keyset-pagination cursor: the sort key and id of the last row of a
+// page, base64url-encoded so clients treat it as a token and pass it back
+// verbatim as ?after=.
+struct Cursor {
+    std::string key;
+    std::int64_t id = 0;
+};
+
+inline std::string encode_cursor(std::string_view key, std::int64_t id) {
+    static constexpr char alphabet[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+    std::string raw = std::to_string(id);
+    raw += '|';
+    raw += key;
+
+    std::string out;
+    out.reserve((raw.size() + 2) / 3 * 4);
+    std::uint32_t bits = 0;
+    int nbits = 0;
+    for (unsigned char c : raw) {
+        bits = (bits << 8) | c;
+        nbits += 8;
+        while (nbits >= 6) {
+            nbits -= 6;
+            out += alphabet[(bits >> nbits) & 0x3f];
+        }
+    }
+    if (nbits > 0) {
+        out += alphabet[(bits << (6 - nbits)) & 0x3f];
+    }
+    return out;
+}
+
+inline std::optional<Cursor> decode_cursor(std::string_view token) {
+    std::string raw;
+    std::uint32_t bits = 0;
+    int nbits = 0;
+    for (char c : token) {
+        int v;
+        if (c >= 'A' && c <= 'Z') v = c - 'A';
+        else if (c >= 'a' && c <= 'z') v = c - 'a' + 26;
+        else if (c >= '0' && c <= '9') v = c - '0' + 52;
+        else if (c == '-') v = 62;
+        else if (c == '_') v = 63;
+        else return std::nullopt;
+        bits = (bits << 6) | static_cast<std::uint32_t>(v);
+        nbits += 6;
+        if (nbits >= 8) {
+            nbits -= 8;
+            raw += static_cast<char>((bits >> nbits) & 0xff);
+        }
+    }
+
+    auto bar = raw.find('|');
+    if (bar == std::string::npos || bar == 0) {
+        return std::nullopt;
+    }
+    Cursor cursor;
+    try {
+        std::size_t used = 0;
+        cursor.id = std::stoll(raw.substr(0, bar), &used);
+        if (used != bar) return std::nullopt;
+    } catch (const std::exception&) {
+        return std::nullopt;
+    }
+    cursor.key = raw.substr(bar + 1);
+    return cursor;
+}
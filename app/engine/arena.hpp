@@ -0,0 +1,149 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory_resource>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+namespace dbr {
+namespace arena {
+
+// Request-scoped scratch memory.
+//
+// Every httplib worker thread owns one ThreadArena: a monotonic buffer that
+// handlers allocate from while an arena::Scope is alive on that thread. When
+// the outermost Scope ends, the whole request's scratch memory is released
+// at once and the buffer is reused by the next request on the same worker.
+// If a request overflowed the buffer, it is grown (up to max_buffer_size) so
+// that steady-state requests never reach the global heap.
+
+class ThreadArena {
+public:
+    static constexpr std::size_t initial_buffer_size = 64 * 1024;
+    static constexpr std::size_t max_buffer_size = 4 * 1024 * 1024;
+
+    ThreadArena()
+        : buffer_(initial_buffer_size),
+          upstream_(std::pmr::new_delete_resource()),
+          resource_(std::in_place, buffer_.data(), buffer_.size(), &upstream_) {}
+
+    ThreadArena(const ThreadArena&) = delete;
+    ThreadArena& operator=(const ThreadArena&) = delete;
+
+    std::pmr::memory_resource* resource() { return &*resource_; }
+
+    void reset() {
+        std::size_t overflow = upstream_.take_allocated();
+        if (overflow == 0 || buffer_.size() >= max_buffer_size) {
+            resource_->release();
+            return;
+        }
+        std::size_t wanted = buffer_.size();
+        while (wanted < buffer_.size() + overflow && wanted < max_buffer_size) {
+            wanted *= 2;
+        }
+        resource_.reset();
+        buffer_.assign(wanted, std::byte{});
+        resource_.emplace(buffer_.data(), buffer_.size(), &upstream_);
+    }
+
+    std::size_t buffer_size() const { return buffer_.size(); }
+
+    static ThreadArena& current() {
+        thread_local ThreadArena arena;
+        return arena;
+    }
+
+private:
+    // Counts what spills past the local buffer so reset() can size it up
+    class CountingResource : public std::pmr::memory_resource {
+    public:
+        explicit CountingResource(std::pmr::memory_resource* next) : next_(next) {}
+        std::size_t take_allocated() { return std::exchange(allocated_, 0); }
+    private:
+        void* do_allocate(std::size_t bytes, std::size_t align) override {
+            allocated_ += bytes;
+            return next_->allocate(bytes, align);
+        }
+        void do_deallocate(void* p, std::size_t bytes, std::size_t align) override {
+            next_->deallocate(p, bytes, align);
+        }
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+            return this == &other;
+        }
+        std::pmr::memory_resource* next_;
+        std::size_t allocated_ = 0;
+    };
+
+    std::vector<std::byte> buffer_;
+    CountingResource upstream_;
+    std::optional<std::pmr::monotonic_buffer_resource> resource_;
+};
+
+namespace detail {
+inline thread_local int scope_depth = 0;
+}
+
+// RAII marker for "this thread is serving a request". Scopes nest; only the
+// outermost one resets the arena. Anything allocated from the arena (see
+// Allocator, json, string below) must be destroyed before its Scope ends.
+class Scope {
+public:
+    Scope() { ++detail::scope_depth; }
+    ~Scope() {
+        if (--detail::scope_depth == 0) {
+            ThreadArena::current().reset();
+        }
+    }
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+};
+
+// Arena of the active Scope, or the global heap outside of any request
+inline std::pmr::memory_resource* resource() {
+    return detail::scope_depth > 0 ? ThreadArena::current().resource()
+                                   : std::pmr::new_delete_resource();
+}
+
+// Default-constructible allocator bound to the thread's active arena. Unlike
+// std::pmr::polymorphic_allocator it does not need the resource threaded
+// through every constructor, which is what nlohmann::basic_json expects.
+template <typename T>
+class Allocator {
+public:
+    using value_type = T;
+
+    Allocator() noexcept : resource_(arena::resource()) {}
+    template <typename U>
+    Allocator(const Allocator<U>& other) noexcept : resource_(other.resource_) {}
+
+    T* allocate(std::size_t n) {
+        return static_cast<T*>(resource_->allocate(n * sizeof(T), alignof(T)));
+    }
+    void deallocate(T* p, std::size_t n) noexcept {
+        resource_->deallocate(p, n * sizeof(T), alignof(T));
+    }
+
+    template <typename U>
+    bool operator==(const Allocator<U>& other) const noexcept {
+        return resource_ == other.resource_;
+    }
+
+private:
+    template <typename U> friend class Allocator;
+    std::pmr::memory_resource* resource_;
+};
+
+using string = std::basic_string<char, std::char_traits<char>, Allocator<char>>;
+
+// JSON DOM whose nodes, arrays, objects and strings all live in the arena
+using json = nlohmann::basic_json<std::map, std::vector, string, bool,
+                                  std::int64_t, std::uint64_t, double, Allocator>;
+
+} // namespace arena
+} // namespace dbr
@@ -0,0 +1,257 @@
+#include "column_filter.hpp"
+
+#include <algorithm>
+#include <bit>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+#define DBR_COLUMNS_SSE2 1
+// AVX2 and POPCNT variants are compiled in with target attributes and
+// chosen at run time, so the binary still runs on CPUs without them
+#if defined(__GNUC__) || defined(__clang__)
+#define DBR_COLUMNS_AVX2 1
+#endif
+#endif
+
+namespace dbr {
+namespace columns {
+
+namespace {
+
+#if defined(DBR_COLUMNS_AVX2)
+bool use_avx2() {
+    static const bool avx2 = __builtin_cpu_supports("avx2");
+    return avx2;
+}
+
+// Checked on its own: some CPUs without AVX2 still have POPCNT
+bool use_popcnt() {
+    static const bool popcnt = __builtin_cpu_supports("popcnt");
+    return popcnt;
+}
+
+[[gnu::target("avx2")]]
+void between_avx2(const double* column, double lo, double hi, Bitmap& bits) {
+    __m256d vlo = _mm256_set1_pd(lo), vhi = _mm256_set1_pd(hi);
+    for (std::size_t w = 0; w < bits.size(); ++w) {
+        if (!bits[w]) continue;
+        const double* v = column + w * 64;
+        std::uint64_t mask = 0;
+        for (int i = 0; i < 64; i += 4) {
+            __m256d x = _mm256_loadu_pd(v + i);
+            __m256d ok = _mm256_and_pd(_mm256_cmp_pd(x, vlo, _CMP_GE_OQ), _mm256_cmp_pd(x, vhi, _CMP_LE_OQ));
+            mask |= static_cast<std::uint64_t>(_mm256_movemask_pd(ok)) << i;
+        }
+        bits[w] &= mask;
+    }
+}
+
+[[gnu::target("avx2")]]
+void between_avx2(const std::int32_t* column, std::int32_t lo, std::int32_t hi, Bitmap& bits) {
+    __m256i vlo = _mm256_set1_epi32(lo), vhi = _mm256_set1_epi32(hi);
+    for (std::size_t w = 0; w < bits.size(); ++w) {
+        if (!bits[w]) continue;
+        const std::int32_t* v = column + w * 64;
+        std::uint64_t mask = 0;
+        for (int i = 0; i < 64; i += 8) {
+            __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(v + i));
+            __m256i out = _mm256_or_si256(_mm256_cmpgt_epi32(vlo, x), _mm256_cmpgt_epi32(x, vhi));
+            auto fails = static_cast<std::uint64_t>(_mm256_movemask_ps(_mm256_castsi256_ps(out)));
+            mask |= (~fails & 0xff) << i;
+        }
+        bits[w] &= mask;
+    }
+}
+
+[[gnu::target("avx2")]]
+void equal_avx2(const std::uint32_t* column, std::uint32_t wanted, Bitmap& bits) {
+    __m256i vw = _mm256_set1_epi32(static_cast<int>(wanted));
+    for (std::size_t w = 0; w < bits.size(); ++w) {
+        if (!bits[w]) continue;
+        const std::uint32_t* v = column + w * 64;
+        std::uint64_t mask = 0;
+        for (int i = 0; i < 64; i += 8) {
+            __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(v + i));
+            __m256i eq = _mm256_cmpeq_epi32(x, vw);
+            mask |= static_cast<std::uint64_t>(_mm256_movemask_ps(_mm256_castsi256_ps(eq))) << i;
+        }
+        bits[w] &= mask;
+    }
+}
+
+[[gnu::target("avx2")]]
+void masked_avx2(const std::uint8_t* column, std::uint8_t mask_bits, std::uint8_t wanted, Bitmap& bits) {
+    __m256i vm = _mm256_set1_epi8(static_cast<char>(mask_bits));
+    __m256i vw = _mm256_set1_epi8(static_cast<char>(wanted));
+    for (std::size_t w = 0; w < bits.size(); ++w) {
+        if (!bits[w]) continue;
+        const std::uint8_t* v = column + w * 64;
+        std::uint64_t mask = 0;
+        for (int i = 0; i < 64; i += 32) {
+            __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(v + i));
+            __m256i eq = _mm256_cmpeq_epi8(_mm256_and_si256(x, vm), vw);
+            mask |= static_cast<std::uint64_t>(static_cast<std::uint32_t>(_mm256_movemask_epi8(eq))) << i;
+        }
+        bits[w] &= mask;
+    }
+}
+
+[[gnu::target("popcnt")]]
+std::size_t count_popcnt(const Bitmap& bits) {
+    std::size_t n = 0;
+    for (auto word : bits) {
+        n += static_cast<std::size_t>(__builtin_popcountll(word));
+    }
+    return n;
+}
+
+[[gnu::target("popcnt")]]
+std::size_t count_and_popcnt(const std::uint64_t* a, const std::uint64_t* b, std::size_t words) {
+    std::size_t n = 0;
+    for (std::size_t i = 0; i < words; ++i) {
+        n += static_cast<std::size_t>(__builtin_popcountll(a[i] & b[i]));
+    }
+    return n;
+}
+#endif
+
+} // namespace
+
+Bitmap all_rows(std::size_t rows, std::size_t capacity) {
+    Bitmap bits(padded(capacity) / 64, 0);
+    std::size_t full = rows / 64;
+    std::fill(bits.begin(), bits.begin() + static_cast<std::ptrdiff_t>(full), ~0ull);
+    if (rows % 64) {
+        bits[full] = (1ull << (rows % 64)) - 1;
+    }
+    return bits;
+}
+
+void keep_between(const double* column, double lo, double hi, Bitmap& bits) {
+#if defined(DBR_COLUMNS_AVX2)
+    if (use_avx2()) return between_avx2(column, lo, hi, bits);
+#endif
+    for (std::size_t w = 0; w < bits.size(); ++w) {
+        if (!bits[w]) continue;
+        const double* v = column + w * 64;
+        std::uint64_t mask = 0;
+#if defined(DBR_COLUMNS_SSE2)
+        __m128d vlo = _mm_set1_pd(lo), vhi = _mm_set1_pd(hi);
+        for (int i = 0; i < 64; i += 2) {
+            __m128d x = _mm_loadu_pd(v + i);
+            __m128d ok = _mm_and_pd(_mm_cmpge_pd(x, vlo), _mm_cmple_pd(x, vhi));
+            mask |= static_cast<std::uint64_t>(_mm_movemask_pd(ok)) << i;
+        }
+#else
+        for (int i = 0; i < 64; ++i) {
+            mask |= static_cast<std::uint64_t>(v[i] >= lo && v[i] <= hi) << i;
+        }
+#endif
+        bits[w] &= mask;
+    }
+}
+
+void keep_between(const std::int32_t* column, std::int32_t lo, std::int32_t hi, Bitmap& bits) {
+#if defined(DBR_COLUMNS_AVX2)
+    if (use_avx2()) return between_avx2(column, lo, hi, bits);
+#endif
+    for (std::size_t w = 0; w < bits.size(); ++w) {
+        if (!bits[w]) continue;
+        const std::int32_t* v = column + w * 64;
+        std::uint64_t mask = 0;
+#if defined(DBR_COLUMNS_SSE2)
+        __m128i vlo = _mm_set1_epi32(lo), vhi = _mm_set1_epi32(hi);
+        for (int i = 0; i < 64; i += 4) {
+            __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(v + i));
+            __m128i out = _mm_or_si128(_mm_cmplt_epi32(x, vlo), _mm_cmpgt_epi32(x, vhi));
+            auto fails = static_cast<std::uint64_t>(_mm_movemask_ps(_mm_castsi128_ps(out)));
+            mask |= (~fails & 0xf) << i;
+        }
+#else
+        for (int i = 0; i < 64; ++i) {
+            mask |= static_cast<std::uint64_t>(v[i] >= lo && v[i] <= hi) << i;
+        }
+#endif
+        bits[w] &= mask;
+    }
+}
+
+void keep_equal(const std::uint32_t* column, std::uint32_t wanted, Bitmap& bits) {
+#if defined(DBR_COLUMNS_AVX2)
+    if (use_avx2()) return equal_avx2(column, wanted, bits);
+#endif
+    for (std::size_t w = 0; w < bits.size(); ++w) {
+        if (!bits[w]) continue;
+        const std::uint32_t* v = column + w * 64;
+        std::uint64_t mask = 0;
+#if defined(DBR_COLUMNS_SSE2)
+        __m128i vw = _mm_set1_epi32(static_cast<int>(wanted));
+        for (int i = 0; i < 64; i += 4) {
+            __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(v + i));
+            __m128i eq = _mm_cmpeq_epi32(x, vw);
+            mask |= static_cast<std::uint64_t>(_mm_movemask_ps(_mm_castsi128_ps(eq))) << i;
+        }
+#else
+        for (int i = 0; i < 64; ++i) {
+            mask |= static_cast<std::uint64_t>(v[i] == wanted) << i;
+        }
+#endif
+        bits[w] &= mask;
+    }
+}
+
+void keep_masked(const std::uint8_t* column, std::uint8_t mask_bits, std::uint8_t wanted, Bitmap& bits) {
+#if defined(DBR_COLUMNS_AVX2)
+    if (use_avx2()) return masked_avx2(column, mask_bits, wanted, bits);
+#endif
+    for (std::size_t w = 0; w < bits.size(); ++w) {
+        if (!bits[w]) continue;
+        const std::uint8_t* v = column + w * 64;
+        std::uint64_t mask = 0;
+#if defined(DBR_COLUMNS_SSE2)
+        __m128i vm = _mm_set1_epi8(static_cast<char>(mask_bits));
+        __m128i vw = _mm_set1_epi8(static_cast<char>(wanted));
+        for (int i = 0; i < 64; i += 16) {
+            __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(v + i));
+            __m128i eq = _mm_cmpeq_epi8(_mm_and_si128(x, vm), vw);
+            mask |= static_cast<std::uint64_t>(_mm_movemask_epi8(eq)) << i;
+        }
+#else
+        for (int i = 0; i < 64; ++i) {
+            mask |= static_cast<std::uint64_t>((v[i] & mask_bits) == wanted) << i;
+        }
+#endif
+        bits[w] &= mask;
+    }
+}
+
+void keep_selected(const Bitmap& other, Bitmap& bits) {
+    for (std::size_t w = 0; w < bits.size(); ++w) {
+        bits[w] &= w < other.size() ? other[w] : 0;
+    }
+}
+
+std::size_t count(const Bitmap& bits) {
+#if defined(DBR_COLUMNS_AVX2)
+    if (use_popcnt()) return count_popcnt(bits);
+#endif
+    std::size_t n = 0;
+    for (auto word : bits) {
+        n += static_cast<std::size_t>(std::popcount(word));
+    }
+    return n;
+}
+
+std::size_t count_and(const std::uint64_t* a, const std::uint64_t* b, std::size_t words) {
+#if defined(DBR_COLUMNS_AVX2)
+    if (use_popcnt()) return count_and_popcnt(a, b, words);
+#endif
+    std::size_t n = 0;
+    for (std::size_t i = 0; i < words; ++i) {
+        n += static_cast<std::size_t>(std::popcount(a[i] & b[i]));
+    }
+    return n;
+}
+
+} // namespace columns
+} // namespace dbr
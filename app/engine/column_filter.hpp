@@ -0,0 +1,73 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace dbr {
+namespace columns {
+
+// Predicate kernels over struct-of-arrays columns.
+//
+// A selection is a bitmap with one bit per row (bit i % 64 of word i / 64).
+// Each kernel clears the bits of the rows whose value fails its predicate,
+// so a conjunction is a sequence of calls on the same bitmap. Words that are
+// already zero are skipped; the others are evaluated 64 rows at a time with
+// SIMD compares whose lane masks are packed straight into the word. On
+// x86-64 the AVX2 kernels are picked at run time when the CPU has AVX2 and
+// SSE2 is used otherwise; counts use the POPCNT instruction when the CPU
+// has it. Elsewhere plain loops are left for the compiler to vectorize.
+//
+// Columns must hold bits.size() * 64 values: callers pad them to a multiple
+// of 64 rows. Padding rows are never selected, so their values do not matter.
+
+using Bitmap = std::vector<std::uint64_t>;
+
+constexpr std::size_t padded(std::size_t rows) { return (rows + 63) / 64 * 64; }
+
+// Bitmap with the first `rows` of `capacity` rows selected
+Bitmap all_rows(std::size_t rows, std::size_t capacity);
+
+// lo <= value <= hi
+void keep_between(const double* column, double lo, double hi, Bitmap& bits);
+void keep_between(const std::int32_t* column, std::int32_t lo, std::int32_t hi, Bitmap& bits);
+
+// value == wanted
+void keep_equal(const std::uint32_t* column, std::uint32_t wanted, Bitmap& bits);
+
+// (value & mask) == wanted
+void keep_masked(const std::uint8_t* column, std::uint8_t mask, std::uint8_t wanted, Bitmap& bits);
+
+// bits &= other
+void keep_selected(const Bitmap& other, Bitmap& bits);
+
+std::size_t count(const Bitmap& bits);
+
+// Number of bits set in both a[0 .. words) and b[0 .. words)
+std::size_t count_and(const std::uint64_t* a, const std::uint64_t* b, std::size_t words);
+
+// Calls fn(row) for every selected row from `first` on, in row order, until
+// fn returns false
+template <typename Fn>
+void for_each_from(const Bitmap& bits, std::size_t first, Fn&& fn) {
+    for (std::size_t w = first / 64; w < bits.size(); ++w) {
+        std::uint64_t word = bits[w];
+        if (w == first / 64) {
+            word &= ~0ull << (first % 64);
+        }
+        while (word) {
+            if (!fn(w * 64 + static_cast<std::size_t>(std::countr_zero(word)))) {
+                return;
+            }
+            word &= word - 1;
+        }
+    }
+}
+
+inline bool selected(const Bitmap& bits, std::size_t row) {
+    return (bits[row / 64] >> (row % 64)) & 1;
+}
+
+} // namespace columns
+} // namespace dbr
@@ -0,0 +1,201 @@
+#include "db_backup.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <filesystem>
+#include <system_error>
+#include <utility>
+
+namespace dbr {
+namespace db {
+
+const char* BackupProgress::state_name(State state) {
+    switch (state) {
+        case State::Idle: return "idle";
+        case State::Running: return "running";
+        case State::Done: return "done";
+        case State::Failed: return "failed";
+    }
+    return "unknown";
+}
+
+BackupRunner::BackupRunner(std::shared_ptr<ConnectionPool> pool, BackupOptions options)
+    : pool_(std::move(pool)), options_(std::move(options)) {
+    thread_ = std::thread([this] { run(); });
+}
+
+BackupRunner::~BackupRunner() {
+    stop();
+}
+
+void BackupRunner::stop() {
+    {
+        std::lock_guard lock(mutex_);
+        if (stopping_) return;
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+bool BackupRunner::request(std::string path) {
+    {
+        std::lock_guard lock(mutex_);
+        if (stopping_ || requested_ || progress_.state == BackupProgress::State::Running) {
+            return false;
+        }
+        requested_ = path.empty() ? options_.path : std::move(path);
+    }
+    wake_.notify_all();
+    return true;
+}
+
+BackupProgress BackupRunner::progress() const {
+    std::lock_guard lock(mutex_);
+    return progress_;
+}
+
+void BackupRunner::run() {
+    auto next_scheduled = std::chrono::steady_clock::now() + options_.interval;
+    for (;;) {
+        std::string path;
+        {
+            std::unique_lock lock(mutex_);
+            auto ready = [this] { return stopping_ || requested_.has_value(); };
+            if (options_.interval.count() > 0) {
+                if (!wake_.wait_until(lock, next_scheduled, ready)) {
+                    requested_ = options_.path;
+                }
+            } else {
+                wake_.wait(lock, ready);
+            }
+            if (stopping_) {
+                return;
+            }
+            path = std::move(*requested_);
+            requested_.reset();
+        }
+        backup(path);
+        next_scheduled = std::chrono::steady_clock::now() + options_.interval;
+    }
+}
+
+// Sleeps between steps; false if the runner is stopping
+bool BackupRunner::step_pause() {
+    std::unique_lock lock(mutex_);
+    return !wake_.wait_for(lock, options_.pause, [this] { return stopping_; });
+}
+
+void BackupRunner::backup(const std::string& path) {
+    using Clock = std::chrono::steady_clock;
+    auto started = Clock::now();
+    std::string tmp = path + ".tmp";
+    {
+        std::lock_guard lock(mutex_);
+        progress_ = BackupProgress{.state = BackupProgress::State::Running, .path = path};
+    }
+    auto fail = [&](std::string error) {
+        spdlog::error("Backup to {} failed: {}", path, error);
+        std::lock_guard lock(mutex_);
+        progress_.state = BackupProgress::State::Failed;
+        progress_.error = std::move(error);
+        progress_.finished_at = std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    };
+
+    std::error_code ec;
+    std::filesystem::remove(tmp, ec);
+    sqlite3* dest = nullptr;
+    if (sqlite3_open_v2(tmp.c_str(), &dest, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, nullptr) != SQLITE_OK) {
+        fail(dest ? sqlite3_errmsg(dest) : "cannot open destination");
+        sqlite3_close_v2(dest);
+        return;
+    }
+
+    sqlite3_backup* backup;
+    int page_size = 0;
+    {
+        auto source = pool_->writer();
+        backup = sqlite3_backup_init(dest, "main", source, "main");
+        sqlite3_stmt* stmt = nullptr;
+        if (sqlite3_prepare_v2(source, "PRAGMA page_size", -1, &stmt, nullptr) == SQLITE_OK
+            && sqlite3_step(stmt) == SQLITE_ROW) {
+            page_size = sqlite3_column_int(stmt, 0);
+        }
+        sqlite3_finalize(stmt);
+    }
+    if (!backup) {
+        fail(sqlite3_errmsg(dest));
+        sqlite3_close_v2(dest);
+        std::filesystem::remove(tmp, ec);
+        return;
+    }
+
+    int rc = SQLITE_OK;
+    std::uint64_t pages_copied = 0;
+    int last_remaining = -1;
+    bool stopped = false;
+    while (rc == SQLITE_OK || rc == SQLITE_BUSY || rc == SQLITE_LOCKED) {
+        int remaining;
+        int total;
+        {
+            auto source = pool_->writer();
+            rc = sqlite3_backup_step(backup, options_.pages_per_step);
+            remaining = sqlite3_backup_remaining(backup);
+            total = sqlite3_backup_pagecount(backup);
+        }
+        // Writes between steps can grow the remaining count
+        int before = last_remaining < 0 ? total : last_remaining;
+        if (before > remaining) {
+            pages_copied += before - remaining;
+        }
+        last_remaining = remaining;
+        double elapsed = std::chrono::duration<double>(Clock::now() - started).count();
+        {
+            std::lock_guard lock(mutex_);
+            progress_.pages_total = total;
+            progress_.pages_remaining = remaining;
+            progress_.bytes_copied = pages_copied * static_cast<std::uint64_t>(page_size);
+            progress_.elapsed_seconds = elapsed;
+            progress_.bytes_per_second = elapsed > 0 ? progress_.bytes_copied / elapsed : 0.0;
+        }
+        if (rc == SQLITE_DONE) {
+            break;
+        }
+        if (!step_pause()) {
+            stopped = true;
+            break;
+        }
+    }
+
+    {
+        auto source = pool_->writer();
+        sqlite3_backup_finish(backup);
+    }
+    int dest_rc = sqlite3_errcode(dest);
+    sqlite3_close_v2(dest);
+
+    if (stopped || rc != SQLITE_DONE || dest_rc != SQLITE_OK) {
+        fail(stopped ? "stopped" : sqlite3_errstr(rc != SQLITE_DONE ? rc : dest_rc));
+        std::filesystem::remove(tmp, ec);
+        return;
+    }
+    std::filesystem::rename(tmp, path, ec);
+    if (ec) {
+        fail("cannot replace " + path + ": " + ec.message());
+        std::filesystem::remove(tmp, ec);
+        return;
+    }
+
+    std::lock_guard lock(mutex_);
+    progress_.state = BackupProgress::State::Done;
+    progress_.finished_at = std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    spdlog::info("Backup to {} done: {} pages in {:.2f}s ({:.1f} MiB/s)", path, progress_.pages_total,
+                 progress_.elapsed_seconds, progress_.bytes_per_second / (1024 * 1024));
+}
+
+} // namespace db
+} // namespace dbr
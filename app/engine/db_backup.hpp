@@ -0,0 +1,83 @@
+#pragma once
+
+#include <sqlite3.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+
+#include "engine/db_pool.hpp"
+
+namespace dbr {
+namespace db {
+
+struct BackupOptions {
+    std::string path;                               // default destination
+    std::chrono::minutes interval{0};               // scheduled backups; 0 = off
+    int pages_per_step = 128;
+    std::chrono::milliseconds pause{10};            // between steps
+};
+
+struct BackupProgress {
+    enum class State { Idle, Running, Done, Failed };
+    State state = State::Idle;
+    std::string path;
+    int pages_total = 0;
+    int pages_remaining = 0;
+    std::uint64_t bytes_copied = 0;
+    double elapsed_seconds = 0.0;
+    double bytes_per_second = 0.0;
+    std::string error;
+    std::int64_t finished_at = 0;                   // unix seconds of the last Done/Failed
+
+    static const char* state_name(State state);
+};
+
+// Online backup of the pool's database with the incremental backup API.
+//
+// A worker thread copies `pages_per_step` pages at a time and sleeps
+// `pause` between steps. Each step holds the write lease, so the writer
+// connection is the backup source: writes made through it between steps
+// are folded into the copy instead of restarting it, and API writes wait
+// at most one step. The copy goes to "<path>.tmp" and is renamed over the
+// destination only once complete, so the destination is always a
+// consistent snapshot.
+class BackupRunner {
+public:
+    BackupRunner(std::shared_ptr<ConnectionPool> pool, BackupOptions options);
+    ~BackupRunner();
+    BackupRunner(const BackupRunner&) = delete;
+    BackupRunner& operator=(const BackupRunner&) = delete;
+
+    // Starts a backup to `path` (options().path if empty). Returns false if
+    // one is already queued or running.
+    bool request(std::string path = {});
+
+    BackupProgress progress() const;
+    const BackupOptions& options() const { return options_; }
+
+    void stop();
+
+private:
+    void run();
+    void backup(const std::string& path);
+    bool step_pause();
+
+    std::shared_ptr<ConnectionPool> pool_;
+    BackupOptions options_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;
+    std::optional<std::string> requested_;
+    bool stopping_ = false;
+    BackupProgress progress_;
+    std::thread thread_;
+};
+
+} // namespace db
+} // namespace dbr
@@ -0,0 +1,101 @@
+#include "db_connection.hpp"
+
+#include <spdlog/spdlog.h>
+
+namespace dbr {
+namespace db {
+
+void Statement::release() {
+    if (!stmt_) return;
+    sqlite3_reset(stmt_);
+    sqlite3_clear_bindings(stmt_);
+    if (leased_) {
+        *leased_ = false;
+    } else {
+        sqlite3_finalize(stmt_);
+    }
+    stmt_ = nullptr;
+}
+
+Connection::~Connection() {
+    clear_statements();
+    sqlite3_close_v2(db_);
+}
+
+Statement Connection::prepare(std::string_view sql) {
+    auto it = statements_.find(sql);
+    if (it != statements_.end() && !it->second.leased) {
+        hits_.fetch_add(1, std::memory_order_relaxed);
+        it->second.leased = true;
+        return Statement(it->second.stmt, &it->second.leased);
+    }
+
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v3(db_, sql.data(), static_cast<int>(sql.size()),
+                           SQLITE_PREPARE_PERSISTENT, &stmt, nullptr) != SQLITE_OK) {
+        spdlog::error("Failed to prepare statement: {}", sqlite3_errmsg(db_));
+        sqlite3_finalize(stmt);
+        return Statement();
+    }
+
+    if (it != statements_.end()) {
+        // Same query already in flight on this connection: one-off statement
+        return Statement(stmt, nullptr);
+    }
+
+    auto [slot, inserted] = statements_.emplace(std::string(sql), CachedStatement{stmt, true});
+    cached_.fetch_add(1, std::memory_order_relaxed);
+    return Statement(stmt, &slot->second.leased);
+}
+
+void Connection::clear_statements() {
+    for (auto& [sql, entry] : statements_) {
+        sqlite3_finalize(entry.stmt);
+    }
+    cached_.fetch_sub(statements_.size(), std::memory_order_relaxed);
+    statements_.clear();
+}
+
+StatementStats Connection::statement_stats() const {
+    return StatementStats{
+        .hits = hits_.load(std::memory_order_relaxed),
+        .misses = misses_.load(std::memory_order_relaxed),
+        .cached = cached_.load(std::memory_order_relaxed),
+    };
+}
+
+std::vector<std::string> full_scans(sqlite3* db, std::string_view sql,
+                                    const std::vector<std::string>& allowed) {
+    std::vector<std::string> scans;
+    std::string explain = "EXPLAIN QUERY PLAN ";
+    explain.append(sql);
+
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, explain.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+        scans.push_back(std::string("prepare failed: ") + sqlite3_errmsg(db));
+        sqlite3_finalize(stmt);
+        return scans;
+    }
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        auto text = sqlite3_column_text(stmt, 3);
+        std::string_view detail = text ? reinterpret_cast<const char*>(text) : "";
+        if (!detail.starts_with("SCAN ") || detail.find(" USING ") != std::string_view::npos
+            || detail.find(" VIRTUAL TABLE ") != std::string_view::npos) {
+            continue;
+        }
+        std::string_view relation = detail.substr(5, detail.find(' ', 5) - 5);
+        bool is_allowed = false;
+        for (auto& name : allowed) {
+            is_allowed = is_allowed || relation == name;
+        }
+        if (!is_allowed) {
+            scans.emplace_back(detail);
+        }
+    }
+    sqlite3_finalize(stmt);
+    return scans;
+}
+
+} // namespace db
+} // namespace dbr
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <sqlite3.h>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace dbr {
+namespace db {
+
+// Lease on a prepared statement. On destruction the statement is reset and
+// its bindings cleared, then handed back to the connection's cache for the
+// next caller with the same SQL text (one-off statements are finalized).
+class Statement {
+public:
+    Statement() = default;
+    Statement(sqlite3_stmt* stmt, bool* leased) : stmt_(stmt), leased_(leased) {}
+    ~Statement() { release(); }
+
+    Statement(Statement&& other) noexcept
+        : stmt_(std::exchange(other.stmt_, nullptr)), leased_(other.leased_) {}
+    Statement& operator=(Statement&& other) noexcept {
+        if (this != &other) {
+            release();
+            stmt_ = std::exchange(other.stmt_, nullptr);
+            leased_ = other.leased_;
+        }
+        return *this;
+    }
+    Statement(const Statement&) = delete;
+    Statement& operator=(const Statement&) = delete;
+
+    sqlite3_stmt* get() const { return stmt_; }
+    operator sqlite3_stmt*() const { return stmt_; }
+    explicit operator bool() const { return stmt_ != nullptr; }
+
+    void release();
+
+private:
+    sqlite3_stmt* stmt_ = nullptr;
+    bool* leased_ = nullptr;
+};
+
+struct StatementStats {
+    std::uint64_t hits = 0;
+    std::uint64_t misses = 0;
+    std::uint64_t cached = 0;
+
+    StatementStats& operator+=(const StatementStats& o) {
+        hits += o.hits;
+        misses += o.misses;
+        cached += o.cached;
+        return *this;
+    }
+    double hit_rate() const {
+        auto total = hits + misses;
+        return total ? static_cast<double>(hits) / static_cast<double>(total) : 0.0;
+    }
+};
+
+// One open sqlite3 handle plus its prepared-statement cache. A Connection is
+// only ever used by one thread at a time (its owning worker, or whoever holds
+// the write lease), so handles are opened with SQLITE_OPEN_NOMUTEX and the
+// cache needs no locking; only the counters are read from other threads.
+class Connection {
+public:
+    explicit Connection(sqlite3* db) : db_(db) {}
+    ~Connection();
+    Connection(const Connection&) = delete;
+    Connection& operator=(const Connection&) = delete;
+
+    sqlite3* get() const { return db_; }
+    operator sqlite3*() const { return db_; }
+
+    // Prepared statement for `sql`, compiled once per connection and reused.
+    // If the cached statement is already leased (re-entrant use of the same
+    // query), a one-off statement is prepared instead. Returns an empty
+    // Statement if the SQL does not compile.
+    Statement prepare(std::string_view sql);
+
+    // Finalizes every cached statement (e.g. after the schema was replaced).
+    // No statement may be leased at the time.
+    void clear_statements();
+
+    StatementStats statement_stats() const;
+
+private:
+    struct CachedStatement {
+        sqlite3_stmt* stmt = nullptr;
+        bool leased = false;
+    };
+    struct SqlHash {
+        using is_transparent = void;
+        std::size_t operator()(std::string_view s) const { return std::hash<std::string_view>{}(s); }
+    };
+
+    sqlite3* db_;
+    std::unordered_map<std::string, CachedStatement, SqlHash, std::equal_to<>> statements_;
+    std::atomic<std::uint64_t> hits_{0};
+    std::atomic<std::uint64_t> misses_{0};
+    std::atomic<std::uint64_t> cached_{0};
+};
+
+// Plan steps of `sql` that read a whole table without an index, i.e. an
+// EXPLAIN QUERY PLAN "SCAN x" line with no USING clause. Relations named in
+// `allowed` are not reported. Returns a single "prepare failed: ..." entry if
+// the SQL does not compile.
+std::vector<std::string> full_scans(sqlite3* db, std::string_view sql,
+                                    const std::vector<std::string>& allowed = {});
+
+} // namespace db
+} // namespace dbr
@@ -0,0 +1,219 @@
+#include "db_maintenance.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <string>
+#include <utility>
+
+namespace dbr {
+namespace db {
+
+namespace {
+
+int pragma_int(sqlite3* db, const char* sql) {
+    sqlite3_stmt* stmt = nullptr;
+    int value = -1;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) == SQLITE_OK && sqlite3_step(stmt) == SQLITE_ROW) {
+        value = sqlite3_column_int(stmt, 0);
+    }
+    sqlite3_finalize(stmt);
+    return value;
+}
+
+std::int64_t unix_now() {
+    return std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+const char* MaintenanceStats::task_name(Task task) {
+    switch (task) {
+        case Optimize: return "optimize";
+        case Vacuum: return "incremental_vacuum";
+        case Checkpoint: return "checkpoint";
+        case Truncate: return "checkpoint_truncate";
+        case TaskCount: break;
+    }
+    return "unknown";
+}
+
+MaintenanceScheduler::MaintenanceScheduler(std::shared_ptr<ConnectionPool> pool, MaintenanceOptions options)
+    : pool_(std::move(pool)), options_(options), last_activity_(Clock::now().time_since_epoch().count()) {
+    thread_ = std::thread([this] { run(); });
+}
+
+MaintenanceScheduler::~MaintenanceScheduler() {
+    stop();
+}
+
+void MaintenanceScheduler::stop() {
+    {
+        std::lock_guard lock(mutex_);
+        if (stopping_) return;
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void MaintenanceScheduler::note_activity() {
+    last_activity_.store(Clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+}
+
+MaintenanceStats MaintenanceScheduler::stats() const {
+    std::lock_guard lock(mutex_);
+    return stats_;
+}
+
+bool MaintenanceScheduler::idle() const {
+    Clock::time_point last{Clock::duration(last_activity_.load(std::memory_order_relaxed))};
+    return Clock::now() - last >= options_.idle;
+}
+
+void MaintenanceScheduler::run() {
+    const std::array<Clock::duration, MaintenanceStats::TaskCount> intervals{
+        options_.optimize_interval, options_.vacuum_interval,
+        options_.checkpoint_interval, options_.truncate_interval,
+    };
+    // Everything is due at the first quiet moment after startup
+    std::array<Clock::time_point, MaintenanceStats::TaskCount> due;
+    due.fill(Clock::now());
+    std::array<bool, MaintenanceStats::TaskCount> put_off{};
+
+    for (;;) {
+        {
+            std::unique_lock lock(mutex_);
+            if (wake_.wait_for(lock, options_.poll, [this] { return stopping_; })) {
+                return;
+            }
+        }
+        auto now = Clock::now();
+        bool quiet = idle();
+        // One task per poll, so traffic is checked again before the next
+        for (int i = 0; i < MaintenanceStats::TaskCount; ++i) {
+            auto task = static_cast<Task>(i);
+            if (now < due[i]) continue;
+            if (!quiet) {
+                if (!put_off[i]) {
+                    put_off[i] = true;
+                    std::lock_guard lock(mutex_);
+                    ++stats_.deferred;
+                }
+                continue;
+            }
+
+            auto started_at = unix_now();
+            auto started = Clock::now();
+            Outcome outcome;
+            switch (task) {
+                case MaintenanceStats::Optimize: outcome = optimize(); break;
+                case MaintenanceStats::Vacuum: outcome = vacuum(); break;
+                case MaintenanceStats::Checkpoint: outcome = checkpoint(SQLITE_CHECKPOINT_PASSIVE); break;
+                case MaintenanceStats::Truncate: outcome = checkpoint(SQLITE_CHECKPOINT_TRUNCATE); break;
+                case MaintenanceStats::TaskCount: break;
+            }
+            double seconds = std::chrono::duration<double>(Clock::now() - started).count();
+            spdlog::debug("Maintenance {}: {} ({:.3f}s)", MaintenanceStats::task_name(task), outcome.result, seconds);
+
+            put_off[i] = false;
+            due[i] = Clock::now() + (outcome.finished ? intervals[i] : Clock::duration(options_.idle));
+            std::lock_guard lock(mutex_);
+            auto& stats = stats_.tasks[i];
+            ++stats.runs;
+            stats.last_run_at = started_at;
+            stats.last_seconds = seconds;
+            stats.last_result = std::move(outcome.result);
+            break;
+        }
+    }
+}
+
+// Refreshes the planner statistics of the tables whose contents have
+// changed enough to matter; the first run also covers tables that have
+// never been analyzed. analysis_limit keeps each table's ANALYZE to a
+// sample, so the run stays short however large the tables grow.
+MaintenanceScheduler::Outcome MaintenanceScheduler::optimize() {
+    auto writer = pool_->writer();
+    char* err = nullptr;
+    const char* sql = analyzed_ ? "PRAGMA analysis_limit = 400; PRAGMA optimize"
+                                : "PRAGMA analysis_limit = 400; PRAGMA optimize = 0x10002";
+    int rc = sqlite3_exec(writer, sql, nullptr, nullptr, &err);
+    std::string result = rc == SQLITE_OK ? "ok" : (err ? err : sqlite3_errstr(rc));
+    sqlite3_free(err);
+    if (rc == SQLITE_OK) {
+        analyzed_ = true;
+    } else {
+        spdlog::warn("PRAGMA optimize failed: {}", result);
+    }
+    return {result};
+}
+
+// A truncating checkpoint must not wait for readers: the busy timeout is
+// lifted for its duration, and a checkpoint blocked by a reader reports
+// "busy" and is retried later.
+MaintenanceScheduler::Outcome MaintenanceScheduler::checkpoint(int mode) {
+    auto writer = pool_->writer();
+    bool truncate = mode == SQLITE_CHECKPOINT_TRUNCATE;
+    if (truncate) {
+        sqlite3_busy_timeout(writer, 0);
+    }
+    int log = 0;
+    int checkpointed = 0;
+    int rc = sqlite3_wal_checkpoint_v2(writer, nullptr, mode, &log, &checkpointed);
+    if (truncate) {
+        sqlite3_busy_timeout(writer, pool_->options().busy_timeout_ms);
+    }
+    if (rc == SQLITE_BUSY) {
+        return {"busy", !truncate};
+    }
+    if (rc != SQLITE_OK) {
+        spdlog::warn("WAL checkpoint failed: {}", sqlite3_errmsg(writer));
+        return {sqlite3_errstr(rc)};
+    }
+    return {std::to_string(checkpointed) + " of " + std::to_string(log) + " frames"};
+}
+
+// Frees pages a step at a time, releasing the write lease in between, until
+// the free list is empty, the time box is used up or a request comes in
+MaintenanceScheduler::Outcome MaintenanceScheduler::vacuum() {
+    auto deadline = Clock::now() + options_.time_box;
+    {
+        auto writer = pool_->writer();
+        if (pragma_int(writer, "PRAGMA auto_vacuum") != 2) {
+            return {"not enabled"};
+        }
+    }
+    std::string step = "PRAGMA incremental_vacuum(" + std::to_string(options_.vacuum_pages_per_step) + ")";
+    int freed = 0;
+    int left = 0;
+    for (;;) {
+        {
+            auto writer = pool_->writer();
+            int before = pragma_int(writer, "PRAGMA freelist_count");
+            if (before > 0) {
+                char* err = nullptr;
+                if (sqlite3_exec(writer, step.c_str(), nullptr, nullptr, &err) != SQLITE_OK) {
+                    std::string error = err ? err : "unknown error";
+                    sqlite3_free(err);
+                    spdlog::warn("{} failed: {}", step, error);
+                    return {error};
+                }
+            }
+            left = pragma_int(writer, "PRAGMA freelist_count");
+            freed += before - left;
+        }
+        if (left <= 0 || Clock::now() >= deadline || !idle()) {
+            break;
+        }
+    }
+    if (left > 0) {
+        return {std::to_string(freed) + " pages freed, " + std::to_string(left) + " left", false};
+    }
+    return {std::to_string(freed) + " pages freed"};
+}
+
+} // namespace db
+} // namespace dbr
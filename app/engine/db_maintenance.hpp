@@ -0,0 +1,108 @@
+#pragma once
+
+#include <sqlite3.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "engine/db_pool.hpp"
+
+namespace dbr {
+namespace db {
+
+struct MaintenanceOptions {
+    std::chrono::milliseconds idle{2000};               // quiet time before a task may start
+    std::chrono::milliseconds poll{500};
+    std::chrono::milliseconds time_box{100};            // longest run of a stepped task
+    std::chrono::minutes optimize_interval{60};
+    std::chrono::minutes vacuum_interval{5};
+    std::chrono::seconds checkpoint_interval{60};
+    std::chrono::minutes truncate_interval{15};
+    int vacuum_pages_per_step = 64;
+};
+
+struct MaintenanceTaskStats {
+    std::uint64_t runs = 0;
+    std::int64_t last_run_at = 0;                       // unix seconds of the last start
+    double last_seconds = 0.0;
+    std::string last_result;                            // e.g. "ok", "busy", "12 pages freed"
+};
+
+struct MaintenanceStats {
+    // In the order they run when several are due: the checkpoints come last
+    // so they also pick up the pages written by the others
+    enum Task { Optimize, Vacuum, Checkpoint, Truncate, TaskCount };
+    std::array<MaintenanceTaskStats, TaskCount> tasks;
+    std::uint64_t deferred = 0;                         // due tasks put off by traffic
+
+    static const char* task_name(Task task);
+};
+
+// Keeps the database tidy in the background: PRAGMA optimize (refreshes
+// the planner statistics), passive WAL checkpoints, truncating checkpoints
+// that shrink the WAL file back to zero, and incremental_vacuum to hand
+// free pages back to the file system.
+//
+// Tasks only start once no request has been seen for `idle`; the server
+// reports traffic with note_activity(). Each task holds the write lease
+// for one short step at a time. A truncating checkpoint does not wait for
+// readers to finish, and incremental_vacuum frees `vacuum_pages_per_step`
+// pages per step for at most `time_box`. A task put off by traffic, or cut
+// short by it, runs again at the next quiet moment.
+//
+// incremental_vacuum needs auto_vacuum=INCREMENTAL, which the pool sets on
+// new databases. Older files keep auto_vacuum=NONE until they are VACUUMed,
+// and the task reports "not enabled".
+class MaintenanceScheduler {
+public:
+    MaintenanceScheduler(std::shared_ptr<ConnectionPool> pool, MaintenanceOptions options);
+    ~MaintenanceScheduler();
+    MaintenanceScheduler(const MaintenanceScheduler&) = delete;
+    MaintenanceScheduler& operator=(const MaintenanceScheduler&) = delete;
+
+    // Records API traffic; cheap enough to call on every request
+    void note_activity();
+
+    MaintenanceStats stats() const;
+    const MaintenanceOptions& options() const { return options_; }
+
+    void stop();
+
+private:
+    using Clock = std::chrono::steady_clock;
+    using Task = MaintenanceStats::Task;
+
+    // Result of one run of a task; unfinished work is picked up at the next
+    // quiet moment instead of after the task's interval
+    struct Outcome {
+        std::string result;
+        bool finished = true;
+    };
+
+    void run();
+    bool idle() const;
+    Outcome optimize();
+    Outcome checkpoint(int mode);
+    Outcome vacuum();
+
+    std::shared_ptr<ConnectionPool> pool_;
+    MaintenanceOptions options_;
+    std::atomic<Clock::rep> last_activity_;
+    bool analyzed_ = false;                             // worker thread only
+
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;
+    bool stopping_ = false;
+    MaintenanceStats stats_;
+    std::thread thread_;
+};
+
+} // namespace db
+} // namespace dbr
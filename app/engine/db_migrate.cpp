@@ -0,0 +1,69 @@
+#include "db_migrate.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <string>
+
+namespace dbr {
+namespace db {
+
+namespace {
+
+bool exec(sqlite3* db, const char* sql, const char* what) {
+    char* err = nullptr;
+    if (sqlite3_exec(db, sql, nullptr, nullptr, &err) != SQLITE_OK) {
+        spdlog::error("{} failed: {}", what, err ? err : sqlite3_errmsg(db));
+        sqlite3_free(err);
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+int schema_version(sqlite3* db) {
+    sqlite3_stmt* stmt = nullptr;
+    int version = -1;
+    if (sqlite3_prepare_v2(db, "PRAGMA user_version", -1, &stmt, nullptr) == SQLITE_OK
+        && sqlite3_step(stmt) == SQLITE_ROW) {
+        version = sqlite3_column_int(stmt, 0);
+    }
+    sqlite3_finalize(stmt);
+    return version;
+}
+
+ErrorCode migrate(sqlite3* db, std::span<const Migration> migrations) {
+    int current = schema_version(db);
+    if (current < 0) {
+        spdlog::error("Cannot read schema version: {}", sqlite3_errmsg(db));
+        return ErrorCode::UnknownError;
+    }
+    int latest = migrations.empty() ? 0 : migrations.back().version;
+    if (current >= latest) {
+        if (current > latest) {
+            spdlog::warn("Database schema version {} is newer than this build ({})", current, latest);
+        }
+        return ErrorCode::Success;
+    }
+
+    for (auto& migration : migrations) {
+        if (migration.version <= current) {
+            continue;
+        }
+        spdlog::info("Migrating database to version {}: {}", migration.version, migration.description);
+        if (!exec(db, "BEGIN IMMEDIATE", "Starting migration")) {
+            return ErrorCode::UnknownError;
+        }
+        std::string bump = "PRAGMA user_version = " + std::to_string(migration.version);
+        if (!exec(db, migration.sql, migration.description) || !exec(db, bump.c_str(), bump.c_str())
+            || !exec(db, "COMMIT", "Committing migration")) {
+            exec(db, "ROLLBACK", "Rolling back migration");
+            return ErrorCode::UnknownError;
+        }
+        current = migration.version;
+    }
+    return ErrorCode::Success;
+}
+
+} // namespace db
+} // namespace dbr
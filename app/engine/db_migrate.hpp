@@ -0,0 +1,31 @@
+#pragma once
+
+#include <sqlite3.h>
+
+#include <span>
+
+#include "common_defs.hpp"
+
+namespace dbr {
+namespace db {
+
+// One schema step. `version` numbers are consecutive from 1; the database
+// records the last one applied in PRAGMA user_version.
+struct Migration {
+    int version;
+    const char* description;
+    const char* sql;
+};
+
+// Brings the database up to the last of `migrations`. Each pending step runs
+// in its own IMMEDIATE transaction together with the user_version bump, so a
+// failing step leaves the database at the previous version. When the schema
+// is current this is a single pragma read. A database from a newer build
+// (user_version past the last migration) is left alone with a warning.
+ErrorCode migrate(sqlite3* db, std::span<const Migration> migrations);
+
+// Current PRAGMA user_version, or -1 if it cannot be read
+int schema_version(sqlite3* db);
+
+} // namespace db
+} // namespace dbr
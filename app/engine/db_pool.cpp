@@ -0,0 +1,226 @@
+#include "db_pool.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <atomic>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace dbr {
+namespace db {
+
+namespace {
+
+std::atomic<std::uint64_t> next_pool_id{1};
+
+// Per-thread lookup of "my reader for pool N". Pools are keyed by a serial
+// number rather than by address so a recycled address can never hand out a
+// connection belonging to a destroyed pool.
+struct ThreadReaders {
+    std::vector<std::pair<std::uint64_t, Connection*>> entries;
+
+    Connection* find(std::uint64_t pool_id) const {
+        for (auto& [id, conn] : entries) {
+            if (id == pool_id) return conn;
+        }
+        return nullptr;
+    }
+};
+
+thread_local ThreadReaders thread_readers;
+
+void exec_pragma(sqlite3* db, const std::string& sql) {
+    char* err = nullptr;
+    if (sqlite3_exec(db, sql.c_str(), nullptr, nullptr, &err) != SQLITE_OK) {
+        spdlog::warn("{} failed: {}", sql, err ? err : "unknown error");
+    }
+    sqlite3_free(err);
+}
+
+std::uint64_t random_epoch() {
+    std::random_device rd;
+    return (static_cast<std::uint64_t>(rd()) << 32) | rd();
+}
+
+} // namespace
+
+ConnectionPool::ConnectionPool(PoolOptions options)
+    : options_(std::move(options)), id_(next_pool_id++), epoch_(random_epoch()) { }
+
+ConnectionPool::~ConnectionPool() {
+    // Connections still registered in other threads' lookup tables become
+    // unreachable: their pool id is never handed out again.
+    readers_.clear();
+    writer_.reset();
+}
+
+sqlite3* ConnectionPool::open_connection(int flags) const {
+    sqlite3* db = nullptr;
+    int rc = sqlite3_open_v2(options_.path.c_str(), &db, flags | SQLITE_OPEN_NOMUTEX, nullptr);
+    if (rc != SQLITE_OK) {
+        spdlog::error("Cannot open database {}: {}", options_.path,
+                      db ? sqlite3_errmsg(db) : sqlite3_errstr(rc));
+        sqlite3_close_v2(db);
+        return nullptr;
+    }
+    apply_pragmas(db);
+    return db;
+}
+
+void ConnectionPool::apply_pragmas(sqlite3* db) const {
+    sqlite3_busy_timeout(db, options_.busy_timeout_ms);
+    exec_pragma(db, "PRAGMA mmap_size = " + std::to_string(options_.mmap_size));
+    exec_pragma(db, "PRAGMA cache_size = -" + std::to_string(options_.cache_size_kib));
+    exec_pragma(db, "PRAGMA temp_store = MEMORY");
+}
+
+ErrorCode ConnectionPool::open() {
+    std::lock_guard lock(writer_mutex_);
+    if (writer_) {
+        return ErrorCode::Success;
+    }
+
+    sqlite3* db = open_connection(SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE);
+    if (!db) {
+        return ErrorCode::UnknownError;
+    }
+    writer_ = std::make_unique<Connection>(db);
+    install_hooks(db);
+    // Lets the maintenance scheduler hand free pages back with
+    // incremental_vacuum. Only takes effect on a new, empty database;
+    // existing files keep their mode until they are VACUUMed.
+    exec_pragma(db, "PRAGMA auto_vacuum = INCREMENTAL");
+
+    sqlite3_stmt* stmt = nullptr;
+    std::string mode;
+    if (sqlite3_prepare_v2(db, "PRAGMA journal_mode = WAL", -1, &stmt, nullptr) == SQLITE_OK
+        && sqlite3_step(stmt) == SQLITE_ROW) {
+        mode = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+    }
+    sqlite3_finalize(stmt);
+    if (mode != "wal") {
+        spdlog::warn("Database {} is not in WAL mode (journal_mode={})", options_.path, mode);
+    }
+
+    spdlog::debug("Opened database {} (journal_mode={})", options_.path, mode);
+    return ErrorCode::Success;
+}
+
+Connection& ConnectionPool::reader() {
+    if (auto* conn = thread_readers.find(id_)) {
+        return *conn;
+    }
+
+    sqlite3* db = open_connection(SQLITE_OPEN_READONLY);
+    if (!db) {
+        throw std::runtime_error("cannot open read connection to " + options_.path);
+    }
+
+    Connection* conn;
+    {
+        std::lock_guard lock(readers_mutex_);
+        readers_.push_back(std::make_unique<Connection>(db));
+        conn = readers_.back().get();
+        spdlog::debug("Opened read connection #{} to {}", readers_.size(), options_.path);
+    }
+    thread_readers.entries.emplace_back(id_, conn);
+    return *conn;
+}
+
+StatementStats ConnectionPool::statement_stats() {
+    StatementStats total;
+    {
+        std::lock_guard lock(readers_mutex_);
+        for (auto& conn : readers_) {
+            total += conn->statement_stats();
+        }
+    }
+    if (writer_) {
+        total += writer_->statement_stats();
+    }
+    return total;
+}
+
+ConnectionPool::WriteLease ConnectionPool::writer() {
+    if (!writer_) {
+        throw std::runtime_error("database pool is not open");
+    }
+    return WriteLease(*this);
+}
+
+ConnectionPool::WriteLease::~WriteLease() {
+    if (pool_) {
+        pool_->end_write(lock_);
+    }
+}
+
+// Every row change on the writer is recorded per table; the set is dropped
+// on rollback and published once the transaction has committed. Only the
+// writer can modify the database, so readers need no hooks.
+void ConnectionPool::install_hooks(sqlite3* db) {
+    sqlite3_update_hook(db, [](void* self, int, const char*, const char* table, sqlite3_int64) {
+        static_cast<ConnectionPool*>(self)->mark_changed(table);
+    }, this);
+    sqlite3_rollback_hook(db, [](void* self) {
+        static_cast<ConnectionPool*>(self)->pending_changes_.clear();
+    }, this);
+}
+
+void ConnectionPool::mark_changed(std::string_view table) {
+    if (std::find(pending_changes_.begin(), pending_changes_.end(), table) == pending_changes_.end()) {
+        pending_changes_.emplace_back(table);
+    }
+}
+
+std::uint64_t ConnectionPool::version(std::initializer_list<std::string_view> tables) {
+    std::lock_guard lock(versions_mutex_);
+    std::uint64_t version = 0;
+    for (auto& [table, changed] : table_versions_) {
+        if (std::find(tables.begin(), tables.end(), table) != tables.end()) {
+            version = std::max(version, changed);
+        }
+    }
+    return version;
+}
+
+void ConnectionPool::on_change(ChangeListener listener) {
+    std::lock_guard lock(listeners_mutex_);
+    listeners_.push_back(std::move(listener));
+}
+
+void ConnectionPool::end_write(std::unique_lock<std::mutex>& lock) {
+    // A lease released mid-transaction keeps its changes for the commit
+    if (pending_changes_.empty() || !sqlite3_get_autocommit(writer_->get())) {
+        return;
+    }
+    std::vector<std::string> tables;
+    tables.swap(pending_changes_);
+    lock.unlock();
+
+    // Listeners drop their caches before the new versions are published: a
+    // reader that sees the new version must not be served the old data
+    {
+        std::lock_guard guard(listeners_mutex_);
+        for (auto& listener : listeners_) {
+            listener(tables);
+        }
+    }
+
+    std::lock_guard guard(versions_mutex_);
+    ++generation_;
+    for (auto& table : tables) {
+        auto it = std::find_if(table_versions_.begin(), table_versions_.end(),
+                               [&](auto& entry) { return entry.first == table; });
+        if (it == table_versions_.end()) {
+            table_versions_.emplace_back(table, generation_);
+        } else {
+            it->second = generation_;
+        }
+    }
+}
+
+} // namespace db
+} // namespace dbr
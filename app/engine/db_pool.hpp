@@ -0,0 +1,121 @@
+#pragma once
+
+#include <sqlite3.h>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "common_defs.hpp"
+#include "engine/db_connection.hpp"
+
+namespace dbr {
+namespace db {
+
+struct PoolOptions {
+    std::string path;
+    int busy_timeout_ms = 5000;
+    std::int64_t mmap_size = 256ll * 1024 * 1024;
+    int cache_size_kib = 16 * 1024;
+};
+
+// WAL-mode connection pool with a read/write split: every thread that asks
+// for reader() gets its own read-only connection, opened on first use and
+// kept for the life of the pool. All writes go through the single writer
+// connection, serialized by WriteLease. In WAL mode readers never block on
+// the writer and vice versa.
+class ConnectionPool {
+public:
+    explicit ConnectionPool(PoolOptions options);
+    ~ConnectionPool();
+    ConnectionPool(const ConnectionPool&) = delete;
+    ConnectionPool& operator=(const ConnectionPool&) = delete;
+
+    // Opens the writer and switches the database to WAL; call before use
+    ErrorCode open();
+
+    // Read-only connection owned by the calling thread.
+    // Throws std::runtime_error if the connection cannot be opened.
+    Connection& reader();
+
+    // Exclusive access to the writer connection. When the lease ends outside
+    // a transaction, the tables written while it was held are published to
+    // the change listeners (after the writer is unlocked).
+    class WriteLease {
+    public:
+        explicit WriteLease(ConnectionPool& pool)
+            : lock_(pool.writer_mutex_), pool_(&pool) {}
+        ~WriteLease();
+        WriteLease(WriteLease&& other) noexcept
+            : lock_(std::move(other.lock_)), pool_(std::exchange(other.pool_, nullptr)) {}
+        WriteLease& operator=(WriteLease&&) = delete;
+
+        Connection& conn() const { return *pool_->writer_; }
+        sqlite3* get() const { return pool_->writer_->get(); }
+        operator sqlite3*() const { return pool_->writer_->get(); }
+        Statement prepare(std::string_view sql) const { return pool_->writer_->prepare(sql); }
+    private:
+        std::unique_lock<std::mutex> lock_;
+        ConnectionPool* pool_;
+    };
+
+    // Exclusive access to the writer connection for the lease's lifetime
+    WriteLease writer();
+
+    // Called with the names of the tables a committed write touched, on the
+    // thread that held the write lease, before version() reports the change.
+    // Register listeners before serving.
+    using ChangeListener = std::function<void(const std::vector<std::string>& tables)>;
+    void on_change(ChangeListener listener);
+
+    // Records a change that sqlite3_update_hook does not report (e.g. a
+    // DELETE without WHERE, or a database replaced wholesale). Must be
+    // called while holding the write lease; published like hooked changes.
+    void mark_changed(std::string_view table);
+
+    // In-process data version of `tables`: the write generation of the last
+    // committed change to any of them (0 if none since the pool opened).
+    // Generations only grow and restart with each pool; pair them with
+    // epoch() when they leave the process.
+    std::uint64_t version(std::initializer_list<std::string_view> tables);
+
+    // Random value fixed for the life of the pool
+    std::uint64_t epoch() const { return epoch_; }
+
+    const PoolOptions& options() const { return options_; }
+
+    // Prepared-statement cache counters summed over every connection
+    StatementStats statement_stats();
+
+private:
+    sqlite3* open_connection(int flags) const;
+    void apply_pragmas(sqlite3* db) const;
+    void install_hooks(sqlite3* db);
+    void end_write(std::unique_lock<std::mutex>& lock);
+
+    PoolOptions options_;
+    const std::uint64_t id_;
+    const std::uint64_t epoch_;
+
+    std::mutex writer_mutex_;
+    std::unique_ptr<Connection> writer_;
+    std::vector<std::string> pending_changes_;   // guarded by writer_mutex_
+
+    std::mutex listeners_mutex_;
+    std::vector<ChangeListener> listeners_;
+
+    std::mutex versions_mutex_;
+    std::uint64_t generation_ = 0;
+    std::vector<std::pair<std::string, std::uint64_t>> table_versions_;
+
+    std::mutex readers_mutex_;
+    std::vector<std::unique_ptr<Connection>> readers_;
+};
+
+} // namespace db
+} // namespace dbr
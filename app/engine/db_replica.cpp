@@ -0,0 +1,258 @@
+#include "db_replica.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include <utility>
+
+namespace dbr {
+namespace db {
+
+namespace {
+
+std::atomic<std::uint64_t> next_replica_id{1};
+
+std::string quoted(std::string_view name) {
+    std::string q = "\"";
+    for (char c : name) {
+        q += c;
+        if (c == '"') q += '"';
+    }
+    q += '"';
+    return q;
+}
+
+bool exec(sqlite3* db, const std::string& sql) {
+    char* err = nullptr;
+    if (sqlite3_exec(db, sql.c_str(), nullptr, nullptr, &err) != SQLITE_OK) {
+        spdlog::error("{} failed: {}", sql, err ? err : "unknown error");
+        sqlite3_free(err);
+        return false;
+    }
+    return true;
+}
+
+std::string column_text(sqlite3_stmt* stmt, int col) {
+    auto text = reinterpret_cast<const char*>(sqlite3_column_text(stmt, col));
+    return text ? text : "";
+}
+
+// Copies `table` from the attached "source" schema into main: its rows, its
+// indexes (created after the rows), and for an FTS5 table the shadow tables
+// that hold the index, so it needs no rebuild.
+bool copy_table(Connection& staging, const std::string& table) {
+    auto entries = staging.prepare(R"(
+        SELECT type, name, sql FROM source.sqlite_schema
+        WHERE tbl_name = ?1 AND sql IS NOT NULL AND type IN ('table', 'index')
+        ORDER BY type = 'index'
+    )");
+    if (!entries) return false;
+    sqlite3_bind_text(entries, 1, table.c_str(), -1, SQLITE_TRANSIENT);
+
+    std::vector<std::string> indexes;
+    bool found = false;
+    while (sqlite3_step(entries) == SQLITE_ROW) {
+        std::string type = column_text(entries, 0), sql = column_text(entries, 2);
+        if (type == "index") {
+            indexes.push_back(std::move(sql));
+            continue;
+        }
+        found = true;
+        if (!exec(staging, sql)) return false;
+        if (!sql.starts_with("CREATE VIRTUAL TABLE")) {
+            if (!exec(staging, "INSERT INTO main." + quoted(table) + " SELECT * FROM source." + quoted(table))) {
+                return false;
+            }
+            continue;
+        }
+        auto shadows = staging.prepare(
+            "SELECT name FROM source.sqlite_schema WHERE type = 'table' AND name GLOB ?1 || '_*'");
+        if (!shadows) return false;
+        sqlite3_bind_text(shadows, 1, table.c_str(), -1, SQLITE_TRANSIENT);
+        while (sqlite3_step(shadows) == SQLITE_ROW) {
+            auto shadow = quoted(column_text(shadows, 0));
+            if (!exec(staging, "INSERT OR REPLACE INTO main." + shadow + " SELECT * FROM source." + shadow)) {
+                return false;
+            }
+        }
+    }
+    if (!found) {
+        spdlog::error("Cannot copy {} into memory: no such table", table);
+        return false;
+    }
+    for (auto& sql : indexes) {
+        if (!exec(staging, sql)) return false;
+    }
+    return true;
+}
+
+} // namespace
+
+MemoryReplica::MemoryReplica(std::shared_ptr<ConnectionPool> source, std::vector<std::string> tables)
+    : source_(std::move(source)), tables_(std::move(tables)), id_(next_replica_id++) { }
+
+MemoryReplica::~MemoryReplica() {
+    // As with ConnectionPool, other threads' lookup entries for this replica
+    // become unreachable: its id is never handed out again
+    readers_.clear();
+}
+
+bool MemoryReplica::covers(std::string_view table) const {
+    return std::find(tables_.begin(), tables_.end(), table) != tables_.end();
+}
+
+void MemoryReplica::invalidate() {
+    generation_.fetch_add(1, std::memory_order_acq_rel);
+    invalidations_.fetch_add(1, std::memory_order_relaxed);
+}
+
+ReplicaStats MemoryReplica::stats() const {
+    auto image = image_.load(std::memory_order_acquire);
+    return {loads_.load(std::memory_order_relaxed), invalidations_.load(std::memory_order_relaxed),
+            image ? image->size : 0, load_seconds_.load(std::memory_order_relaxed)};
+}
+
+ErrorCode MemoryReplica::load() {
+    return current() ? ErrorCode::Success : ErrorCode::UnknownError;
+}
+
+Connection& MemoryReplica::reader() {
+    thread_local std::vector<std::pair<std::uint64_t, Reader*>> thread_readers;
+    Reader* reader = nullptr;
+    for (auto& [id, entry] : thread_readers) {
+        if (id == id_) reader = entry;
+    }
+    if (!reader) {
+        std::lock_guard lock(readers_mutex_);
+        reader = readers_.emplace_back(std::make_unique<Reader>()).get();
+        thread_readers.emplace_back(id_, reader);
+    }
+
+    auto image = current();
+    if (image != reader->image) {
+        map(*reader, std::move(image));
+    }
+    if (!reader->conn) {
+        throw std::runtime_error("cannot load the in-memory copy of " + source_->options().path);
+    }
+    return *reader->conn;
+}
+
+std::shared_ptr<const MemoryReplica::Image> MemoryReplica::current() {
+    auto image = image_.load(std::memory_order_acquire);
+    if (image && image->generation == generation_.load(std::memory_order_acquire)) {
+        return image;
+    }
+
+    std::lock_guard lock(load_mutex_);
+    // Read before the copy starts: a write committing during the copy bumps
+    // the generation and makes this image stale
+    std::uint64_t generation = generation_.load(std::memory_order_acquire);
+    image = image_.load(std::memory_order_acquire);
+    if (image && image->generation == generation) {
+        return image;
+    }
+    if (auto built = build(generation)) {
+        image_.store(built, std::memory_order_release);
+        return built;
+    }
+    // Keep serving the previous image rather than failing every read
+    return image;
+}
+
+std::shared_ptr<const MemoryReplica::Image> MemoryReplica::build(std::uint64_t generation) {
+    auto started = std::chrono::steady_clock::now();
+    sqlite3* db = nullptr;
+    if (sqlite3_open_v2(":memory:", &db, SQLITE_OPEN_READWRITE | SQLITE_OPEN_NOMUTEX, nullptr) != SQLITE_OK) {
+        spdlog::error("Cannot open staging database: {}", db ? sqlite3_errmsg(db) : "out of memory");
+        sqlite3_close_v2(db);
+        return nullptr;
+    }
+    // The attached file may be locked for a moment (WAL recovery, a
+    // checkpoint): wait for it like the pool's own connections do
+    sqlite3_busy_timeout(db, source_->options().busy_timeout_ms);
+    Connection staging(db);
+
+    {
+        auto attach = staging.prepare("ATTACH ?1 AS source");
+        if (!attach) return nullptr;
+        sqlite3_bind_text(attach, 1, source_->options().path.c_str(), -1, SQLITE_TRANSIENT);
+        if (sqlite3_step(attach) != SQLITE_DONE) {
+            spdlog::error("Cannot attach {}: {}", source_->options().path, sqlite3_errmsg(staging));
+            return nullptr;
+        }
+    }
+
+    // One read transaction on the source, so the copied tables agree
+    bool ok = exec(staging, "BEGIN");
+    for (auto& table : tables_) {
+        ok = ok && copy_table(staging, table);
+    }
+    exec(staging, ok ? "COMMIT" : "ROLLBACK");
+    staging.clear_statements();
+    ok = ok && exec(staging, "DETACH source");
+    if (!ok) {
+        return nullptr;
+    }
+
+    auto image = std::make_shared<Image>();
+    image->generation = generation;
+    image->data.reset(sqlite3_serialize(staging, "main", &image->size, 0));
+    if (!image->data) {
+        spdlog::error("Cannot serialize the in-memory copy of {}", source_->options().path);
+        return nullptr;
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    loads_.fetch_add(1, std::memory_order_relaxed);
+    load_seconds_.store(seconds, std::memory_order_relaxed);
+    spdlog::debug("Built in-memory copy {} of {} ({} bytes in {:.3f} s)", generation,
+                  source_->options().path, image->size, seconds);
+    return image;
+}
+
+// Points the reader's connection at `image`. A connection still stepping a
+// statement keeps its current image until the next call.
+bool MemoryReplica::map(Reader& reader, std::shared_ptr<const Image> image) const {
+    if (!image) {
+        return false;
+    }
+    if (!reader.conn) {
+        sqlite3* db = nullptr;
+        if (sqlite3_open_v2(":memory:", &db, SQLITE_OPEN_READWRITE | SQLITE_OPEN_NOMUTEX, nullptr) != SQLITE_OK) {
+            spdlog::error("Cannot open in-memory connection: {}", db ? sqlite3_errmsg(db) : "out of memory");
+            sqlite3_close_v2(db);
+            return false;
+        }
+        sqlite3_busy_timeout(db, source_->options().busy_timeout_ms);
+        reader.conn = std::make_unique<Connection>(db);
+    } else {
+        for (auto* stmt = sqlite3_next_stmt(*reader.conn, nullptr); stmt; stmt = sqlite3_next_stmt(*reader.conn, stmt)) {
+            if (sqlite3_stmt_busy(stmt)) return false;
+        }
+        reader.conn->clear_statements();
+    }
+
+    // Read-only and not resizeable: SQLite reads the shared buffer in place
+    // and never writes to or frees it
+    int rc = sqlite3_deserialize(*reader.conn, "main", image->data.get(), image->size, image->size,
+                                 SQLITE_DESERIALIZE_READONLY);
+    if (rc != SQLITE_OK) {
+        spdlog::error("Cannot map the in-memory copy of {}: {}", source_->options().path,
+                      sqlite3_errmsg(*reader.conn));
+        reader.conn.reset();
+        reader.image.reset();
+        return false;
+    }
+    // Pages are then fetched straight from the image instead of being copied
+    // into the connection's page cache
+    exec(*reader.conn, "PRAGMA mmap_size = " + std::to_string(image->size));
+    exec(*reader.conn, "PRAGMA temp_store = MEMORY");
+    reader.image = std::move(image);
+    return true;
+}
+
+} // namespace db
+} // namespace dbr
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <sqlite3.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "common_defs.hpp"
+#include "engine/db_connection.hpp"
+#include "engine/db_pool.hpp"
+
+namespace dbr {
+namespace db {
+
+struct ReplicaStats {
+    std::uint64_t loads = 0;
+    std::uint64_t invalidations = 0;
+    std::int64_t bytes = 0;            // size of the current image
+    double load_seconds = 0;           // time the last image took to build
+};
+
+// Read-only in-memory copy of a few tables of a pool's database.
+//
+// The tables (with their indexes; FTS5 tables with their shadow tables) are
+// copied from the database file into a staging in-memory database, which is
+// serialized into one immutable image. Every reader thread gets its own
+// connection with the image mapped in through sqlite3_deserialize
+// (SQLITE_DESERIALIZE_READONLY, so all threads share the one buffer), and
+// queries against it never touch the pager cache of the file or the
+// filesystem. Writes keep going to the database file through the pool; a
+// committed write to a copied table must be reported with invalidate(), and
+// the next reader then rebuilds the image while others wait for it.
+class MemoryReplica {
+public:
+    MemoryReplica(std::shared_ptr<ConnectionPool> source, std::vector<std::string> tables);
+    ~MemoryReplica();
+    MemoryReplica(const MemoryReplica&) = delete;
+    MemoryReplica& operator=(const MemoryReplica&) = delete;
+
+    // Builds the image now instead of on first use
+    ErrorCode load();
+
+    // Connection to an up-to-date image, owned by the calling thread.
+    // Throws std::runtime_error if the image cannot be built.
+    Connection& reader();
+
+    // Marks the current image stale
+    void invalidate();
+
+    // True for the tables the image is built from
+    bool covers(std::string_view table) const;
+
+    ReplicaStats stats() const;
+
+private:
+    struct Image {
+        std::uint64_t generation = 0;
+        std::unique_ptr<unsigned char, decltype(&sqlite3_free)> data{nullptr, sqlite3_free};
+        sqlite3_int64 size = 0;
+    };
+    struct Reader {
+        std::unique_ptr<Connection> conn;
+        std::shared_ptr<const Image> image;
+    };
+
+    std::shared_ptr<const Image> current();
+    std::shared_ptr<const Image> build(std::uint64_t generation);
+    bool map(Reader& reader, std::shared_ptr<const Image> image) const;
+
+    std::shared_ptr<ConnectionPool> source_;
+    const std::vector<std::string> tables_;
+    const std::uint64_t id_;
+
+    std::atomic<std::shared_ptr<const Image>> image_;
+    std::atomic<std::uint64_t> generation_{1};
+    std::mutex load_mutex_;
+
+    std::mutex readers_mutex_;
+    std::vector<std::unique_ptr<Reader>> readers_;
+
+    std::atomic<std::uint64_t> loads_{0};
+    std::atomic<std::uint64_t> invalidations_{0};
+    std::atomic<double> load_seconds_{0};
+};
+
+} // namespace db
+} // namespace dbr
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <httplib.h>
+#include <spdlog/spdlog.h>
+#include <sqlite3.h>
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "engine/arena.hpp"
+#include "engine/db_connection.hpp"
+
+namespace dbr {
+namespace db {
+
+// Sends the rows of an already-bound statement as a JSON array using chunked
+// transfer encoding. The statement is stepped lazily from the content
+// provider: each call serializes rows until about `chunk_bytes` are buffered
+// and hands them to the socket, so the first byte leaves right away and
+// memory stays flat however many rows the query returns.
+//
+// `write_row(sqlite3_stmt*, std::string& out)` appends one row's JSON. It
+// runs inside an arena::Scope that ends with each chunk.
+//
+// The statement (and the read transaction it holds) is released when the
+// last row has been sent or the client goes away.
+template <typename RowWriter>
+void stream_json_array(httplib::Response& res, Statement stmt, RowWriter write_row,
+                       std::size_t chunk_bytes = 16 * 1024) {
+    struct State {
+        Statement stmt;
+        RowWriter write_row;
+        std::string buffer;
+        std::size_t rows = 0;
+        bool started = false;
+    };
+    auto state = std::make_shared<State>(State{std::move(stmt), std::move(write_row)});
+    state->buffer.reserve(chunk_bytes + 1024);
+
+    res.set_chunked_content_provider("application/json",
+        [state, chunk_bytes](std::size_t, httplib::DataSink& sink) {
+            arena::Scope scope;
+            auto& buf = state->buffer;
+            buf.clear();
+            if (!state->started) {
+                state->started = true;
+                buf += '[';
+            }
+            while (buf.size() < chunk_bytes) {
+                int rc = sqlite3_step(state->stmt);
+                if (rc == SQLITE_ROW) {
+                    if (state->rows++ > 0) buf += ',';
+                    state->write_row(state->stmt.get(), buf);
+                    continue;
+                }
+                if (rc != SQLITE_DONE) {
+                    spdlog::error("Streaming query failed: {}", sqlite3_errmsg(sqlite3_db_handle(state->stmt)));
+                    return false;
+                }
+                buf += ']';
+                state->stmt.release();
+                if (!sink.write(buf.data(), buf.size())) {
+                    return false;
+                }
+                sink.done();
+                return true;
+            }
+            return sink.write(buf.data(), buf.size());
+        },
+        [state](bool) { state->stmt.release(); });
+}
+
+} // namespace db
+} // namespace dbr
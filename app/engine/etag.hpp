@@ -0,0 +1,72 @@
+#pragma once
+
+#include <httplib.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+
+namespace dbr {
+
+// Validators for responses derived from versioned data.
+//
+// An ETag is W/"<epoch>-<version>-<query hash>": the data version the
+// response was built from (e.g. ConnectionPool::version), the epoch that
+// version counter belongs to, and a hash of the request path plus its
+// parameters in sorted order. Equal tags mean the same query over the same
+// data, so a matching If-None-Match can be answered with 304 before any
+// query runs. Tags are weak because the body may be re-encoded in transit.
+
+// FNV-1a; stable across builds, unlike std::hash
+inline std::uint64_t fnv1a(std::string_view s, std::uint64_t h = 14695981039346656037ull) {
+    for (unsigned char c : s) {
+        h ^= c;
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+// Hash of the path and parameters; parameter order in the URL does not
+// matter (httplib keeps params sorted by key)
+inline std::uint64_t query_hash(const httplib::Request& req) {
+    std::uint64_t h = fnv1a(req.path);
+    for (auto& [key, value] : req.params) {
+        h = fnv1a(value, fnv1a("=", fnv1a(key, fnv1a("&", h))));
+    }
+    return h;
+}
+
+inline std::string make_etag(std::uint64_t epoch, std::uint64_t version, const httplib::Request& req) {
+    char buf[64];
+    int n = std::snprintf(buf, sizeof(buf), "W/\"%llx-%llx-%llx\"",
+                          static_cast<unsigned long long>(epoch),
+                          static_cast<unsigned long long>(version),
+                          static_cast<unsigned long long>(query_hash(req)));
+    return std::string(buf, n);
+}
+
+// True if `etag` is listed in the request's If-None-Match (weak comparison)
+inline bool etag_matches(const httplib::Request& req, std::string_view etag) {
+    if (!req.has_header("If-None-Match")) {
+        return false;
+    }
+    auto opaque = [](std::string_view tag) {
+        return tag.starts_with("W/") ? tag.substr(2) : tag;
+    };
+    std::string header = req.get_header_value("If-None-Match");
+    std::string_view rest = header;
+    while (!rest.empty()) {
+        auto comma = rest.find(',');
+        auto tag = rest.substr(0, comma);
+        rest = comma == std::string_view::npos ? std::string_view() : rest.substr(comma + 1);
+        while (!tag.empty() && tag.front() == ' ') tag.remove_prefix(1);
+        while (!tag.empty() && tag.back() == ' ') tag.remove_suffix(1);
+        if (tag == "*" || opaque(tag) == opaque(etag)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace dbr
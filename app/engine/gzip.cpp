@@ -0,0 +1,105 @@
+#include "gzip.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstddef>
+#include <optional>
+
+namespace dbr {
+
+GzipStream::GzipStream(int level) {
+    // 15 window bits + 16: gzip header and trailer instead of zlib's
+    ok_ = deflateInit2(&zs_, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) == Z_OK;
+}
+
+GzipStream::~GzipStream() {
+    if (ok_) {
+        deflateEnd(&zs_);
+    }
+}
+
+bool GzipStream::write(std::string_view in, std::string& out, bool finish) {
+    if (!ok_) {
+        return false;
+    }
+    zs_.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(in.data()));
+    zs_.avail_in = static_cast<uInt>(in.size());
+    int flush = finish ? Z_FINISH : Z_NO_FLUSH;
+    int rc;
+    do {
+        std::size_t used = out.size();
+        std::size_t room = deflateBound(&zs_, zs_.avail_in) + 64;
+        out.resize(used + room);
+        zs_.next_out = reinterpret_cast<Bytef*>(out.data() + used);
+        zs_.avail_out = static_cast<uInt>(room);
+        rc = deflate(&zs_, flush);
+        out.resize(used + room - zs_.avail_out);
+        if (rc == Z_STREAM_ERROR) {
+            ok_ = false;
+            return false;
+        }
+    } while (zs_.avail_in > 0 || (finish && rc != Z_STREAM_END));
+    return true;
+}
+
+namespace {
+
+std::string_view trim(std::string_view s) {
+    auto first = s.find_first_not_of(" \t");
+    if (first == std::string_view::npos) {
+        return {};
+    }
+    return s.substr(first, s.find_last_not_of(" \t") - first + 1);
+}
+
+bool iequals(std::string_view a, std::string_view b) {
+    return std::ranges::equal(a, b, [](char x, char y) {
+        return std::tolower(static_cast<unsigned char>(x)) == std::tolower(static_cast<unsigned char>(y));
+    });
+}
+
+// Weight of one "coding;q=..." element: 1 without a q parameter, 0 if the
+// q-value does not parse
+double weight(std::string_view params) {
+    while (!params.empty()) {
+        auto semi = params.find(';');
+        auto param = trim(params.substr(0, semi));
+        params = semi == std::string_view::npos ? std::string_view{} : params.substr(semi + 1);
+        if (param.size() < 2 || (param[0] != 'q' && param[0] != 'Q') || param[1] != '=') {
+            continue;
+        }
+        auto value = trim(param.substr(2));
+        double q = 0;
+        auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), q);
+        if (ec != std::errc() || end != value.data() + value.size() || !(q >= 0 && q <= 1)) {
+            return 0;
+        }
+        return q;
+    }
+    return 1;
+}
+
+} // namespace
+
+bool accepts_gzip(std::string_view accept_encoding) {
+    // An explicit "gzip" entry decides; otherwise "*" covers it (RFC 9110)
+    std::optional<double> gzip;
+    std::optional<double> any;
+    while (!accept_encoding.empty()) {
+        auto comma = accept_encoding.find(',');
+        auto element = accept_encoding.substr(0, comma);
+        accept_encoding = comma == std::string_view::npos ? std::string_view{} : accept_encoding.substr(comma + 1);
+        auto semi = element.find(';');
+        auto coding = trim(element.substr(0, semi));
+        auto params = semi == std::string_view::npos ? std::string_view{} : element.substr(semi + 1);
+        if (iequals(coding, "gzip")) {
+            gzip = weight(params);
+        } else if (coding == "*") {
+            any = weight(params);
+        }
+    }
+    return gzip ? *gzip > 0 : any && *any > 0;
+}
+
+} // namespace dbr
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <zlib.h>
+
+#include <string>
+#include <string_view>
+
+namespace dbr {
+
+// Incremental gzip encoder for streamed responses. Input is compressed as
+// it is written; compressed bytes are appended to the caller's buffer
+// whenever zlib has some ready, so output can be flushed chunk by chunk.
+class GzipStream {
+public:
+    explicit GzipStream(int level = Z_BEST_SPEED);
+    ~GzipStream();
+    GzipStream(const GzipStream&) = delete;
+    GzipStream& operator=(const GzipStream&) = delete;
+
+    explicit operator bool() const { return ok_; }
+
+    // Compresses `in`, appending any output to `out`. With `finish` the
+    // stream is terminated (gzip trailer written); no more input after that.
+    bool write(std::string_view in, std::string& out, bool finish = false);
+
+private:
+    z_stream zs_{};
+    bool ok_ = false;
+};
+
+// True if the Accept-Encoding header value allows gzip
+bool accepts_gzip(std::string_view accept_encoding);
+
+} // namespace dbr
@@ -129,7 +129,8 @@ ErrorCode Server::configure() {
     spdlog::debug("Applying server defaults...");
 
     // Enable CORS for frontend development
-    srv_->set_pre_routing_handler([](const Request& req, Response& res) {
+    srv_->set_pre_routing_handler([this](const Request& req, Response& res) {
+        on_request_activity(req);
         res.set_header("Access-Control-Allow-Origin", "*");
         res.set_header("Access-Control-Allow-Methods", "GET, POST, PUT, DELETE, OPTIONS");
         res.set_header("Access-Control-Allow-Headers", "Content-Type, Authorization");
@@ -158,7 +159,8 @@ ErrorCode Server::configure() {
         }
     });
 
-    srv_->set_logger([](const httplib::Request& req, const httplib::Response& res) {
+    srv_->set_logger([this](const httplib::Request& req, const httplib::Response& res) {
+        on_request_activity(req);
         spdlog::info("{} {} -> {} {}", req.method, req.path, res.status, res.reason);
     });
 
@@ -4,6 +4,7 @@
 #include <memory>
 
 #include "common_defs.hpp"
+#include "engine/ipc_handler.hpp"
 
 namespace dbr {
 
@@ -22,9 +23,15 @@ public:
     Server() : srv_(make_unique<httplib::Server>()) { }
     virtual ~Server();
 
+    // Registers the server's own IPC methods; called after configure()
+    virtual void setup_ipc_handlers(ipc::IPCHandlerRegistry& registry) { }
+
 
 protected:
     virtual ErrorCode own_configure(httplib::Server& srv);
+    // Called when a request arrives and again once its response has been
+    // sent, on the worker thread serving it
+    virtual void on_request_activity(const httplib::Request& req) { }
     std::unique_ptr<std::thread> thread_;
     std::unique_ptr<httplib::Server> srv_;
     bool is_configured_ = false;
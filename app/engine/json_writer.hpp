@@ -0,0 +1,75 @@
+#pragma once
+
+#include <charconv>
+#include <cmath>
+#include <concepts>
+#include <cstdint>
+#include <string_view>
+
+namespace dbr {
+namespace json_writer {
+
+// Append-only JSON primitives for hot serialization paths that write
+// straight into a response buffer instead of building a DOM. `Out` is any
+// std::basic_string<char> (std::string, arena::string, ...). Output matches
+// what nlohmann::json::dump() produces for the same values.
+
+template <typename Out>
+void append_string(Out& out, std::string_view s) {
+    static constexpr char hex[] = "0123456789abcdef";
+    out += '"';
+    std::size_t run = 0;
+    for (std::size_t i = 0; i < s.size(); ++i) {
+        unsigned char c = static_cast<unsigned char>(s[i]);
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+        }
+        out.append(s.data() + run, i - run);
+        run = i + 1;
+        switch (c) {
+            case '"':  out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\b': out += "\\b"; break;
+            case '\f': out += "\\f"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default: {
+                char esc[6] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xf]};
+                out.append(esc, sizeof(esc));
+            }
+        }
+    }
+    out.append(s.data() + run, s.size() - run);
+    out += '"';
+}
+
+template <typename Out, std::integral T>
+void append_number(Out& out, T value) {
+    char buf[24];
+    auto [end, ec] = std::to_chars(buf, buf + sizeof(buf), value);
+    out.append(buf, end);
+}
+
+template <typename Out>
+void append_number(Out& out, double value) {
+    if (!std::isfinite(value)) {
+        out += "null";
+        return;
+    }
+    char buf[32];
+    auto [end, ec] = std::to_chars(buf, buf + sizeof(buf), value);
+    out.append(buf, end);
+    // Keep integral doubles recognisable as floats, like nlohmann (800.0)
+    if (std::string_view(buf, end - buf).find_first_of(".e") == std::string_view::npos) {
+        out += ".0";
+    }
+}
+
+template <typename Out>
+void append_bool(Out& out, bool value) {
+    out += value ? "true" : "false";
+}
+
+} // namespace json_writer
+} // namespace dbr
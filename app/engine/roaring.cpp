@@ -0,0 +1,89 @@
+#include "roaring.hpp"
+
+#include <algorithm>
+#include <array>
+
+namespace dbr {
+namespace columns {
+
+void RoaringBitmap::append(std::uint32_t row) {
+    std::uint32_t key = row >> 16;
+    auto low = static_cast<std::uint16_t>(row & 0xffff);
+    if (containers_.empty() || containers_.back().key != key) {
+        containers_.push_back({key});
+    }
+    auto& c = containers_.back();
+    if (c.words.empty()) {
+        c.array.push_back(low);
+        if (c.array.size() > max_array) {
+            c.words.assign(chunk_words, 0);
+            for (auto v : c.array) {
+                c.words[v / 64] |= 1ull << (v % 64);
+            }
+            c.array = {};
+        }
+    } else {
+        c.words[low / 64] |= 1ull << (low % 64);
+    }
+    ++size_;
+}
+
+std::size_t RoaringBitmap::bytes() const {
+    std::size_t n = sizeof(*this) + containers_.capacity() * sizeof(Container);
+    for (auto& c : containers_) {
+        n += c.array.capacity() * sizeof(std::uint16_t) + c.words.capacity() * sizeof(std::uint64_t);
+    }
+    return n;
+}
+
+void RoaringBitmap::intersect(Bitmap& bits) const {
+    auto c = containers_.begin();
+    for (std::size_t base = 0; base < bits.size(); base += chunk_words) {
+        std::size_t end = std::min(base + chunk_words, bits.size());
+        while (c != containers_.end() && c->key < base / chunk_words) ++c;
+        if (c == containers_.end() || c->key != base / chunk_words) {
+            std::fill(bits.begin() + static_cast<std::ptrdiff_t>(base),
+                      bits.begin() + static_cast<std::ptrdiff_t>(end), 0);
+            continue;
+        }
+        if (!c->words.empty()) {
+            for (std::size_t w = base; w < end; ++w) {
+                bits[w] &= c->words[w - base];
+            }
+            continue;
+        }
+        // Keep only the array's rows: rebuild the chunk from them
+        std::array<std::uint64_t, chunk_words> kept{};
+        for (auto v : c->array) {
+            std::size_t w = base + v / 64;
+            if (w < end) {
+                kept[v / 64] |= bits[w] & (1ull << (v % 64));
+            }
+        }
+        std::copy(kept.begin(), kept.begin() + static_cast<std::ptrdiff_t>(end - base),
+                  bits.begin() + static_cast<std::ptrdiff_t>(base));
+    }
+}
+
+std::size_t RoaringBitmap::count_in(const Bitmap& bits) const {
+    std::size_t n = 0;
+    for (auto& c : containers_) {
+        std::size_t base = c.key * chunk_words;
+        if (base >= bits.size()) {
+            break;
+        }
+        std::size_t end = std::min(base + chunk_words, bits.size());
+        if (!c.words.empty()) {
+            n += count_and(bits.data() + base, c.words.data(), end - base);
+        } else {
+            for (auto v : c.array) {
+                std::size_t w = base + v / 64;
+                n += w < end ? (bits[w] >> (v % 64)) & 1 : 0;
+            }
+        }
+    }
+    return n;
+}
+
+} // namespace columns
+} // namespace dbr
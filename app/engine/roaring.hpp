@@ -0,0 +1,49 @@
+#pragma once
+
+#include "engine/column_filter.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace dbr {
+namespace columns {
+
+// Compressed set of row numbers in the style of Roaring bitmaps.
+//
+// Rows are grouped by their high 16 bits into chunks of 65536. A chunk holds
+// its low 16 bits as a sorted array while it has at most 4096 rows (two
+// bytes a row) and as a 1024-word bitmap once it has more (one bit a row),
+// so a set costs what the denser of the two layouts would. Sets are built
+// by appending rows in ascending order and are read-only afterwards; they
+// are combined with the dense selection bitmaps of column_filter.hpp.
+class RoaringBitmap {
+public:
+    // Adds `row`, which must be greater than every row added before
+    void append(std::uint32_t row);
+
+    std::size_t size() const { return size_; }
+    std::size_t bytes() const;
+
+    // Clears the rows of `bits` that are not in the set
+    void intersect(Bitmap& bits) const;
+
+    // Number of rows in both the set and `bits`
+    std::size_t count_in(const Bitmap& bits) const;
+
+private:
+    static constexpr std::size_t max_array = 4096;
+    static constexpr std::size_t chunk_words = 65536 / 64;
+
+    struct Container {
+        std::uint32_t key = 0;                  // high 16 bits
+        std::vector<std::uint16_t> array;       // sorted low bits, or
+        std::vector<std::uint64_t> words;       // chunk_words bits
+    };
+
+    std::vector<Container> containers_;         // ascending keys
+    std::size_t size_ = 0;
+};
+
+} // namespace columns
+} // namespace dbr
@@ -0,0 +1,174 @@
+#pragma once
+
+#include <sqlite3.h>
+#include <spdlog/spdlog.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#include "engine/json_writer.hpp"
+
+namespace dbr {
+namespace db {
+
+// Compile-time row descriptors.
+//
+// A row type is a plain struct plus a RowMapper listing its fields once, in
+// SELECT column order:
+//
+//     struct CategoryRow { std::int64_t id; std::string_view name; };
+//     using CategoryMapper = RowMapper<CategoryRow,
+//         Field<"id", &CategoryRow::id>,
+//         Field<"name", &CategoryRow::name>>;
+//
+// From that the mapper generates the sqlite3_column_* reads and a JSON
+// writer with the `,"key":` literals baked in at compile time, so rows go
+// from the statement to the output buffer with no intermediate DOM. The key
+// doubles as the expected result column name; debug builds check it against
+// the statement so a reordered SELECT is caught instead of silently shifting
+// fields. NULL text reads as "", NULL numbers as 0.
+//
+// std::string_view fields point into SQLite's row buffer and are only valid
+// until the statement is stepped again.
+
+template <std::size_t N>
+struct FixedString {
+    char value[N];
+    constexpr FixedString(const char (&s)[N]) {
+        for (std::size_t i = 0; i < N; ++i) value[i] = s[i];
+    }
+    constexpr std::size_t size() const { return N - 1; }
+    constexpr std::string_view view() const { return {value, N - 1}; }
+};
+
+template <typename T> struct member_traits;
+template <typename C, typename V> struct member_traits<V C::*> {
+    using value_type = V;
+};
+
+template <FixedString Key, auto Member>
+struct Field {
+    using value_type = typename member_traits<decltype(Member)>::value_type;
+    static constexpr auto member = Member;
+    static constexpr std::string_view name = Key.view();
+
+    // ,"key": -- the leading comma is skipped for the first field
+    static constexpr auto json_key = [] {
+        std::array<char, Key.size() + 4> k{};
+        k[0] = ',';
+        k[1] = '"';
+        for (std::size_t i = 0; i < Key.size(); ++i) k[i + 2] = Key.value[i];
+        k[Key.size() + 2] = '"';
+        k[Key.size() + 3] = ':';
+        return k;
+    }();
+};
+
+template <typename V>
+V column_value(sqlite3_stmt* stmt, int col) {
+    if constexpr (std::is_same_v<V, bool>) {
+        return sqlite3_column_int(stmt, col) != 0;
+    } else if constexpr (std::is_integral_v<V>) {
+        return static_cast<V>(sqlite3_column_int64(stmt, col));
+    } else if constexpr (std::is_floating_point_v<V>) {
+        return static_cast<V>(sqlite3_column_double(stmt, col));
+    } else if constexpr (std::is_same_v<V, std::string_view> || std::is_same_v<V, std::string>) {
+        auto text = reinterpret_cast<const char*>(sqlite3_column_text(stmt, col));
+        return text ? V(text, static_cast<std::size_t>(sqlite3_column_bytes(stmt, col))) : V();
+    } else {
+        static_assert(sizeof(V) == 0, "unsupported column type");
+    }
+}
+
+template <typename Out, typename V>
+void append_json_value(Out& out, const V& value) {
+    if constexpr (std::is_same_v<V, bool>) {
+        json_writer::append_bool(out, value);
+    } else if constexpr (std::is_arithmetic_v<V>) {
+        json_writer::append_number(out, value);
+    } else {
+        json_writer::append_string(out, value);
+    }
+}
+
+template <typename T, typename... Fields>
+struct RowMapper {
+    using row_type = T;
+    static constexpr int column_count = sizeof...(Fields);
+
+    // Reads the row the statement is positioned on
+    static T read(sqlite3_stmt* stmt) {
+        check_columns(stmt);
+        T row{};
+        read_fields(stmt, row, std::index_sequence_for<Fields...>{});
+        return row;
+    }
+
+    // Serializes an already-read row
+    template <typename Out>
+    static void write_json(const T& row, Out& out) {
+        out += '{';
+        write_fields(row, out, std::index_sequence_for<Fields...>{});
+        out += '}';
+    }
+
+    // Serializes the current row of `stmt` directly, column by column. The
+    // fields start at `first_column`, so one statement can feed several
+    // mappers (e.g. the two sides of a join).
+    template <typename Out>
+    static void write_json(sqlite3_stmt* stmt, Out& out, int first_column = 0) {
+        out += '{';
+        write_members(stmt, out, first_column);
+        out += '}';
+    }
+
+    // The "key":value members of write_json without the enclosing braces
+    template <typename Out>
+    static void write_members(sqlite3_stmt* stmt, Out& out, int first_column = 0) {
+        check_columns(stmt, first_column);
+        write_columns(stmt, out, first_column, std::index_sequence_for<Fields...>{});
+    }
+
+    // Debug builds: the result columns must be named like the fields
+    static void check_columns([[maybe_unused]] sqlite3_stmt* stmt, [[maybe_unused]] int first_column = 0) {
+#ifndef NDEBUG
+        static constexpr std::array<std::string_view, sizeof...(Fields)> names{Fields::name...};
+        for (int i = 0; i < column_count; ++i) {
+            const char* actual = sqlite3_column_name(stmt, first_column + i);
+            if (!actual || names[i] != actual) {
+                spdlog::error("Row mapper column {} is '{}' but the statement returns '{}': {}",
+                              first_column + i, names[i], actual ? actual : "(none)", sqlite3_sql(stmt));
+            }
+        }
+#endif
+    }
+
+private:
+    template <std::size_t... I>
+    static void read_fields(sqlite3_stmt* stmt, T& row, std::index_sequence<I...>) {
+        ((row.*Fields::member = column_value<typename Fields::value_type>(stmt, static_cast<int>(I))), ...);
+    }
+
+    template <typename Out, std::size_t... I>
+    static void write_fields(const T& row, Out& out, std::index_sequence<I...>) {
+        ((out.append(Fields::json_key.data() + (I == 0), Fields::json_key.size() - (I == 0)),
+          append_json_value(out, row.*Fields::member)), ...);
+    }
+
+    template <typename Out, std::size_t... I>
+    static void write_columns(sqlite3_stmt* stmt, Out& out, int first_column, std::index_sequence<I...>) {
+        ((out.append(Fields::json_key.data() + (I == 0), Fields::json_key.size() - (I == 0)),
+          append_json_value(out, column_value<std::conditional_t<
+              std::is_same_v<typename Fields::value_type, std::string>, std::string_view,
+              typename Fields::value_type>>(stmt, first_column + static_cast<int>(I)))), ...);
+    }
+};
+
+} // namespace db
+} // namespace dbr
@@ -0,0 +1,88 @@
+#include "facet_index.hpp"
+#include "engine/json_writer.hpp"
+
+#include <algorithm>
+
+void FacetIndex::add_pet(std::uint32_t row, std::string_view species, bool available) {
+    auto [it, added] = species_ids_.try_emplace(std::string(species), static_cast<std::uint32_t>(species_.size()));
+    if (added) {
+        species_.push_back({std::string(species)});
+    }
+    species_[it->second].rows.append(row);
+    (available ? available_ : unavailable_).append(row);
+}
+
+void FacetIndex::add_category(const std::string& name, const std::vector<std::uint32_t>& rows) {
+    auto& facet = categories_.emplace_back(Facet{name});
+    for (auto row : rows) {
+        facet.rows.append(row);
+    }
+}
+
+void FacetIndex::finish() {
+    species_ids_ = {};
+    auto by_value = [](const Facet& a, const Facet& b) { return a.value < b.value; };
+    std::sort(categories_.begin(), categories_.end(), by_value);
+    std::sort(species_.begin(), species_.end(), by_value);
+}
+
+std::size_t FacetIndex::bytes() const {
+    std::size_t n = available_.bytes() + unavailable_.bytes();
+    for (auto* group : {&categories_, &species_}) {
+        for (auto& facet : *group) {
+            n += facet.value.size() + facet.rows.bytes();
+        }
+    }
+    return n;
+}
+
+void FacetIndex::restrict(const std::vector<Facet>& group, const std::string& wanted, dbr::columns::Bitmap& bits) {
+    auto it = std::lower_bound(group.begin(), group.end(), wanted,
+                               [](const Facet& f, const std::string& v) { return f.value < v; });
+    if (it == group.end() || it->value != wanted) {
+        std::fill(bits.begin(), bits.end(), 0);
+        return;
+    }
+    it->rows.intersect(bits);
+}
+
+std::string FacetIndex::counts(const PetFilter& filter, const dbr::columns::Bitmap& base) const {
+    using dbr::columns::Bitmap;
+    // Base restricted by every group's filter but `skip`'s
+    enum Group { Category, Species, Availability, None };
+    auto selection = [&](Group skip) {
+        Bitmap bits = base;
+        if (skip != Category && filter.category) restrict(categories_, *filter.category, bits);
+        if (skip != Species && filter.species) restrict(species_, *filter.species, bits);
+        if (skip != Availability && filter.available) {
+            (*filter.available ? available_ : unavailable_).intersect(bits);
+        }
+        return bits;
+    };
+    auto append_group = [](std::string& out, const std::vector<Facet>& group, const Bitmap& bits) {
+        out += '[';
+        for (auto& facet : group) {
+            if (&facet != &group.front()) out += ',';
+            out += "{\"value\":";
+            dbr::json_writer::append_string(out, facet.value);
+            out += ",\"count\":";
+            dbr::json_writer::append_number(out, facet.rows.count_in(bits));
+            out += '}';
+        }
+        out += ']';
+    };
+
+    std::string out = "{\"total\":";
+    dbr::json_writer::append_number(out, dbr::columns::count(selection(None)));
+    out += ",\"categories\":";
+    append_group(out, categories_, selection(Category));
+    out += ",\"species\":";
+    append_group(out, species_, selection(Species));
+    auto bits = selection(Availability);
+    out += ",\"available\":{\"true\":";
+    dbr::json_writer::append_number(out, available_.count_in(bits));
+    out += ",\"false\":";
+    dbr::json_writer::append_number(out, unavailable_.count_in(bits));
+    out += "}}";
+    return out;
+}
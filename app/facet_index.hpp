@@ -0,0 +1,55 @@
+#pragma once
+
+#include "engine/column_filter.hpp"
+#include "engine/roaring.hpp"
+#include "pet_index.hpp"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Facet counts behind /api/facets: one compressed set of pets per category,
+// per species and per availability value.
+//
+// Counts come from intersecting those sets with a selection bitmap and
+// counting the result. Each facet group is counted against the filter
+// without the group's own value (multi-select facets), so picking "Cats"
+// still shows how many pets the other categories would offer. Rows are
+// catalog snapshot positions, as in PetIndex. Built once per snapshot and
+// immutable afterwards.
+class FacetIndex {
+public:
+    // Rows must be added in ascending order
+    void add_pet(std::uint32_t row, std::string_view species, bool available);
+    // `rows` must be sorted
+    void add_category(const std::string& name, const std::vector<std::uint32_t>& rows);
+
+    // Orders the values by name; call after the last add
+    void finish();
+
+    // JSON object of the counts for `filter` (category, species and
+    // availability) among the rows of `base`, e.g. the pets in the price
+    // and age ranges: {"total":n,"categories":[{"value":..,"count":n},..],
+    // "species":[..],"available":{"true":n,"false":n}}
+    std::string counts(const PetFilter& filter, const dbr::columns::Bitmap& base) const;
+
+    std::size_t bytes() const;
+
+private:
+    struct Facet {
+        std::string value;
+        dbr::columns::RoaringBitmap rows;
+    };
+
+    // Clears the rows of `bits` outside the facet value `wanted` of `group`
+    // (all of them if the value is unknown)
+    static void restrict(const std::vector<Facet>& group, const std::string& wanted, dbr::columns::Bitmap& bits);
+
+    std::vector<Facet> categories_;
+    std::vector<Facet> species_;
+    std::unordered_map<std::string, std::uint32_t> species_ids_;   // build time only
+    dbr::columns::RoaringBitmap available_;
+    dbr::columns::RoaringBitmap unavailable_;
+};
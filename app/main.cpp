@@ -1,6 +1,7 @@
 #include <memory>
 #include <thread>
 #include <chrono>
+#include <string_view>
 #include "engine/http_server.hpp"
 #include "engine/ipc_handler.hpp"
 #include "common_defs.hpp"
@@ -29,8 +30,15 @@ inline void init_logging() {
     spdlog::set_level(spdlog::level::debug); // overridden by SPDLOG_ACTIVE_LEVEL at compile-time
 }
 
-std::unique_ptr<dbr::Server> make_server() {
-    return std::make_unique<OwnServer>();
+// Application switches; anything else is left for the webview toolkit
+std::unique_ptr<dbr::Server> make_server(int argc, char* argv[]) {
+    OwnServerOptions options;
+    for (int i = 1; i < argc; ++i) {
+        if (std::string_view(argv[i]) == "--catalog-in-memory") {
+            options.catalog_in_memory = true;
+        }
+    }
+    return std::make_unique<OwnServer>(options);
 }
 
 void setup_ipc_handlers(dbr::ipc::IPCHandlerRegistry& registry) {
@@ -92,7 +100,7 @@ int main(int argc, char* argv[]) {
     init_logging();
     spdlog::info("Starting DeskBreeze WebView application...");
 
-    auto server = make_server();
+    auto server = make_server(argc, argv);
     if (!server) {
         spdlog::error("Failed to create server instance");
         return 1;
@@ -113,6 +121,7 @@ int main(int argc, char* argv[]) {
     // Setup IPC
     dbr::ipc::IPCHandlerRegistry ipc_registry;
     setup_ipc_handlers(ipc_registry);
+    server->setup_ipc_handlers(ipc_registry);
     spdlog::info("IPC handlers configured");
 
 #ifdef __linux__
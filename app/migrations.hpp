@@ -0,0 +1,326 @@
+#pragma once
+
+#include "engine/db_migrate.hpp"
+
+#include <array>
+
+// Schema history of petstore.db, applied in order by dbr::db::migrate.
+// Released migrations are never edited: a schema change is a new entry at
+// the end. Version 1 uses IF NOT EXISTS throughout because databases created
+// before versioning already hold these tables at user_version 0.
+namespace migrations {
+
+inline constexpr dbr::db::Migration initial_schema{1, "initial schema", R"(
+    CREATE TABLE IF NOT EXISTS pets (
+        id INTEGER PRIMARY KEY AUTOINCREMENT,
+        name TEXT NOT NULL,
+        species TEXT NOT NULL,
+        breed TEXT,
+        age INTEGER,
+        price REAL NOT NULL,
+        description TEXT,
+        image_url TEXT,
+        available BOOLEAN DEFAULT 1,
+        created_at DATETIME DEFAULT CURRENT_TIMESTAMP
+    );
+
+    CREATE TABLE IF NOT EXISTS categories (
+        id INTEGER PRIMARY KEY AUTOINCREMENT,
+        name TEXT NOT NULL UNIQUE,
+        description TEXT
+    );
+
+    CREATE TABLE IF NOT EXISTS pet_categories (
+        pet_id INTEGER,
+        category_id INTEGER,
+        PRIMARY KEY (pet_id, category_id),
+        FOREIGN KEY (pet_id) REFERENCES pets(id),
+        FOREIGN KEY (category_id) REFERENCES categories(id)
+    );
+
+    CREATE TABLE IF NOT EXISTS orders (
+        id INTEGER PRIMARY KEY AUTOINCREMENT,
+        customer_name TEXT NOT NULL,
+        customer_email TEXT NOT NULL,
+        customer_phone TEXT,
+        total_amount REAL NOT NULL,
+        status TEXT DEFAULT 'pending',
+        created_at DATETIME DEFAULT CURRENT_TIMESTAMP
+    );
+
+    CREATE TABLE IF NOT EXISTS order_items (
+        id INTEGER PRIMARY KEY AUTOINCREMENT,
+        order_id INTEGER,
+        pet_id INTEGER,
+        quantity INTEGER DEFAULT 1,
+        price REAL NOT NULL,
+        FOREIGN KEY (order_id) REFERENCES orders(id),
+        FOREIGN KEY (pet_id) REFERENCES pets(id)
+    );
+
+    -- Full-text index over pets, kept in sync by triggers
+    CREATE VIRTUAL TABLE IF NOT EXISTS pets_fts USING fts5(
+        name, breed, species, description,
+        content='pets', content_rowid='id',
+        tokenize='unicode61 remove_diacritics 2',
+        prefix='2 3'
+    );
+    CREATE TRIGGER IF NOT EXISTS pets_fts_insert AFTER INSERT ON pets BEGIN
+        INSERT INTO pets_fts (rowid, name, breed, species, description)
+        VALUES (new.id, new.name, new.breed, new.species, new.description);
+    END;
+    CREATE TRIGGER IF NOT EXISTS pets_fts_delete AFTER DELETE ON pets BEGIN
+        INSERT INTO pets_fts (pets_fts, rowid, name, breed, species, description)
+        VALUES ('delete', old.id, old.name, old.breed, old.species, old.description);
+    END;
+    CREATE TRIGGER IF NOT EXISTS pets_fts_update AFTER UPDATE ON pets BEGIN
+        INSERT INTO pets_fts (pets_fts, rowid, name, breed, species, description)
+        VALUES ('delete', old.id, old.name, old.breed, old.species, old.description);
+        INSERT INTO pets_fts (rowid, name, breed, species, description)
+        VALUES (new.id, new.name, new.breed, new.species, new.description);
+    END;
+    INSERT INTO pets_fts (pets_fts) VALUES ('rebuild');
+
+    -- Secondary indexes behind the API queries (checked by check_query_plans)
+    CREATE INDEX IF NOT EXISTS idx_pets_available_created ON pets (available, created_at);
+    CREATE INDEX IF NOT EXISTS idx_pet_categories_category ON pet_categories (category_id, pet_id);
+    CREATE INDEX IF NOT EXISTS idx_orders_created ON orders (created_at);
+    CREATE INDEX IF NOT EXISTS idx_order_items_order ON order_items (order_id);
+)"};
+
+// Sample data, only for a catalog that has no pets yet
+inline constexpr dbr::db::Migration sample_catalog{2, "sample catalog", R"(
+    CREATE TEMP TABLE seed AS SELECT NOT EXISTS (SELECT 1 FROM pets) AS empty;
+
+    INSERT OR IGNORE INTO categories (name, description) VALUES
+    ('Dogs', 'Loyal and friendly companions'),
+    ('Cats', 'Independent and playful pets'),
+    ('Birds', 'Colorful and musical friends'),
+    ('Fish', 'Peaceful aquatic companions'),
+    ('Small Animals', 'Hamsters, rabbits, and other small pets');
+
+    INSERT INTO pets (id, name, species, breed, age, price, description, image_url, available)
+    SELECT * FROM (VALUES
+        (1, 'Buddy', 'Dog', 'Golden Retriever', 2, 800.00, 'Friendly and energetic golden retriever, great with kids', '/images/golden-retriever.svg', 1),
+        (2, 'Luna', 'Cat', 'Persian', 1, 600.00, 'Beautiful Persian cat with long silky fur', '/images/persian-cat.svg', 1),
+        (3, 'Charlie', 'Dog', 'Labrador', 3, 750.00, 'Well-trained Labrador, perfect family dog', '/images/labrador.svg', 1),
+        (4, 'Whiskers', 'Cat', 'Siamese', 2, 550.00, 'Elegant Siamese cat with striking blue eyes', '/images/siamese-cat.svg', 1),
+        (5, 'Tweety', 'Bird', 'Canary', 1, 150.00, 'Beautiful singing canary with bright yellow feathers', '/images/canary.svg', 1),
+        (6, 'Nemo', 'Fish', 'Goldfish', 1, 25.00, 'Healthy goldfish perfect for beginners', '/images/goldfish.svg', 1),
+        (7, 'Fluffy', 'Small Animal', 'Rabbit', 1, 120.00, 'Adorable rabbit with soft white fur', '/images/rabbit.svg', 1),
+        (8, 'Max', 'Dog', 'German Shepherd', 4, 900.00, 'Intelligent and protective German Shepherd', '/images/german-shepherd.svg', 1),
+        (9, 'Mittens', 'Cat', 'Maine Coon', 2, 700.00, 'Large and gentle Maine Coon cat', '/images/maine-coon.svg', 1),
+        (10, 'Polly', 'Bird', 'Parrot', 3, 400.00, 'Colorful parrot that can learn to speak', '/images/parrot.svg', 1))
+    WHERE (SELECT empty FROM temp.seed);
+
+    INSERT OR IGNORE INTO pet_categories (pet_id, category_id)
+    SELECT * FROM (VALUES
+        (1, 1), (3, 1), (8, 1),  -- Dogs
+        (2, 2), (4, 2), (9, 2),  -- Cats
+        (5, 3), (10, 3),         -- Birds
+        (6, 4),                  -- Fish
+        (7, 5))                  -- Small Animals
+    WHERE (SELECT empty FROM temp.seed);
+
+    DROP TABLE temp.seed;
+)"};
+
+// Earlier builds re-inserted the sample pets on every launch. Drops pets
+// that duplicate an older row field for field and are not referenced by a
+// category link or an order.
+inline constexpr dbr::db::Migration dedupe_sample_pets{3, "remove duplicate sample pets", R"(
+    DELETE FROM pets
+    WHERE EXISTS (
+        SELECT 1 FROM pets o
+        WHERE o.id < pets.id AND o.name = pets.name AND o.species = pets.species
+            AND o.breed IS pets.breed AND o.age IS pets.age AND o.price = pets.price
+            AND o.description IS pets.description AND o.image_url IS pets.image_url)
+    AND NOT EXISTS (SELECT 1 FROM pet_categories pc WHERE pc.pet_id = pets.id)
+    AND NOT EXISTS (SELECT 1 FROM order_items oi WHERE oi.pet_id = pets.id);
+)"};
+
+// Sales rollups for /api/analytics, kept current by triggers on every
+// order and order item write and filled once from the existing history.
+// Items are attributed to the pet's species and categories at the time of
+// sale.
+inline constexpr dbr::db::Migration sales_rollups{4, "sales rollups", R"(
+    CREATE TABLE sales_by_day (
+        day TEXT PRIMARY KEY,
+        orders INTEGER NOT NULL DEFAULT 0,
+        revenue REAL NOT NULL DEFAULT 0
+    );
+    CREATE TABLE sales_by_status (
+        status TEXT PRIMARY KEY,
+        orders INTEGER NOT NULL DEFAULT 0,
+        revenue REAL NOT NULL DEFAULT 0
+    );
+    CREATE TABLE sales_by_species (
+        species TEXT PRIMARY KEY,
+        units INTEGER NOT NULL DEFAULT 0,
+        revenue REAL NOT NULL DEFAULT 0
+    );
+    CREATE TABLE sales_by_category (
+        category_id INTEGER PRIMARY KEY,
+        units INTEGER NOT NULL DEFAULT 0,
+        revenue REAL NOT NULL DEFAULT 0
+    );
+
+    CREATE TRIGGER sales_order_insert AFTER INSERT ON orders BEGIN
+        INSERT INTO sales_by_day (day, orders, revenue) VALUES (date(new.created_at), 1, new.total_amount)
+        ON CONFLICT (day) DO UPDATE SET orders = orders + 1, revenue = revenue + excluded.revenue;
+        INSERT INTO sales_by_status (status, orders, revenue) VALUES (new.status, 1, new.total_amount)
+        ON CONFLICT (status) DO UPDATE SET orders = orders + 1, revenue = revenue + excluded.revenue;
+    END;
+    CREATE TRIGGER sales_order_status AFTER UPDATE OF status ON orders
+    WHEN old.status IS NOT new.status BEGIN
+        UPDATE sales_by_status SET orders = orders - 1, revenue = revenue - old.total_amount
+        WHERE status = old.status;
+        INSERT INTO sales_by_status (status, orders, revenue) VALUES (new.status, 1, new.total_amount)
+        ON CONFLICT (status) DO UPDATE SET orders = orders + 1, revenue = revenue + excluded.revenue;
+    END;
+    CREATE TRIGGER sales_order_delete AFTER DELETE ON orders BEGIN
+        UPDATE sales_by_day SET orders = orders - 1, revenue = revenue - old.total_amount
+        WHERE day = date(old.created_at);
+        UPDATE sales_by_status SET orders = orders - 1, revenue = revenue - old.total_amount
+        WHERE status = old.status;
+    END;
+
+    CREATE TRIGGER sales_item_insert AFTER INSERT ON order_items BEGIN
+        INSERT INTO sales_by_species (species, units, revenue)
+        SELECT species, new.quantity, new.quantity * new.price FROM pets WHERE id = new.pet_id
+        ON CONFLICT (species) DO UPDATE SET units = units + excluded.units, revenue = revenue + excluded.revenue;
+        INSERT INTO sales_by_category (category_id, units, revenue)
+        SELECT category_id, new.quantity, new.quantity * new.price FROM pet_categories WHERE pet_id = new.pet_id
+        ON CONFLICT (category_id) DO UPDATE SET units = units + excluded.units, revenue = revenue + excluded.revenue;
+    END;
+    CREATE TRIGGER sales_item_delete AFTER DELETE ON order_items BEGIN
+        UPDATE sales_by_species SET units = units - old.quantity, revenue = revenue - old.quantity * old.price
+        WHERE species = (SELECT species FROM pets WHERE id = old.pet_id);
+        UPDATE sales_by_category SET units = units - old.quantity, revenue = revenue - old.quantity * old.price
+        WHERE category_id IN (SELECT category_id FROM pet_categories WHERE pet_id = old.pet_id);
+    END;
+
+    -- One-time backfill from the existing history
+    INSERT INTO sales_by_day (day, orders, revenue)
+    SELECT date(created_at), COUNT(*), SUM(total_amount) FROM orders GROUP BY 1;
+    INSERT INTO sales_by_status (status, orders, revenue)
+    SELECT status, COUNT(*), SUM(total_amount) FROM orders GROUP BY 1;
+    INSERT INTO sales_by_species (species, units, revenue)
+    SELECT p.species, SUM(oi.quantity), SUM(oi.quantity * oi.price)
+    FROM order_items oi JOIN pets p ON p.id = oi.pet_id GROUP BY 1;
+    INSERT INTO sales_by_category (category_id, units, revenue)
+    SELECT pc.category_id, SUM(oi.quantity), SUM(oi.quantity * oi.price)
+    FROM order_items oi JOIN pet_categories pc ON pc.pet_id = oi.pet_id GROUP BY 1;
+)"};
+
+// Per-order item aggregates stored on the order row, so the admin listing
+// reads orders alone instead of counting order_items for every row.
+// order_items triggers keep them current; existing orders are backfilled.
+inline constexpr dbr::db::Migration order_item_totals{5, "order item totals", R"(
+    ALTER TABLE orders ADD COLUMN item_count INTEGER NOT NULL DEFAULT 0;
+    ALTER TABLE orders ADD COLUMN item_subtotal REAL NOT NULL DEFAULT 0;
+
+    CREATE TRIGGER order_totals_item_insert AFTER INSERT ON order_items BEGIN
+        UPDATE orders SET item_count = item_count + 1,
+            item_subtotal = item_subtotal + new.quantity * new.price
+        WHERE id = new.order_id;
+    END;
+    CREATE TRIGGER order_totals_item_update AFTER UPDATE OF order_id, quantity, price ON order_items BEGIN
+        UPDATE orders SET item_count = item_count - 1,
+            item_subtotal = item_subtotal - old.quantity * old.price
+        WHERE id = old.order_id;
+        UPDATE orders SET item_count = item_count + 1,
+            item_subtotal = item_subtotal + new.quantity * new.price
+        WHERE id = new.order_id;
+    END;
+    CREATE TRIGGER order_totals_item_delete AFTER DELETE ON order_items BEGIN
+        UPDATE orders SET item_count = item_count - 1,
+            item_subtotal = item_subtotal - old.quantity * old.price
+        WHERE id = old.order_id;
+    END;
+
+    UPDATE orders SET item_count = t.n, item_subtotal = t.subtotal
+    FROM (SELECT order_id, COUNT(*) AS n, SUM(quantity * price) AS subtotal
+          FROM order_items GROUP BY order_id) AS t
+    WHERE orders.id = t.order_id;
+)"};
+
+// One row per customer, keyed by the normalized (trimmed, lowercased)
+// email, with lifetime order totals. Orders point at their customer and
+// are indexed by it, so a customer's history is a range of
+// idx_orders_customer in (created_at, id) order. An order insert upserts
+// its customer and bumps the totals; a delete takes its amount back out
+// (first and last order dates are not rewound). Existing orders are
+// backfilled.
+inline constexpr dbr::db::Migration customers{6, "customers", R"(
+    CREATE TABLE customers (
+        id INTEGER PRIMARY KEY,
+        email TEXT NOT NULL UNIQUE,
+        order_count INTEGER NOT NULL DEFAULT 0,
+        total_spent REAL NOT NULL DEFAULT 0,
+        first_order_at DATETIME,
+        last_order_at DATETIME
+    );
+    ALTER TABLE orders ADD COLUMN customer_id INTEGER REFERENCES customers(id);
+
+    INSERT INTO customers (email, order_count, total_spent, first_order_at, last_order_at)
+    SELECT lower(trim(customer_email)), COUNT(*), SUM(total_amount), MIN(created_at), MAX(created_at)
+    FROM orders GROUP BY 1;
+    UPDATE orders SET customer_id = c.id
+    FROM customers c
+    WHERE c.email = lower(trim(orders.customer_email));
+    CREATE INDEX idx_orders_customer ON orders(customer_id, created_at);
+
+    CREATE TRIGGER customer_order_insert AFTER INSERT ON orders BEGIN
+        INSERT INTO customers (email, order_count, total_spent, first_order_at, last_order_at)
+        VALUES (lower(trim(new.customer_email)), 1, new.total_amount, new.created_at, new.created_at)
+        ON CONFLICT (email) DO UPDATE SET order_count = order_count + 1,
+            total_spent = total_spent + excluded.total_spent,
+            last_order_at = max(last_order_at, excluded.last_order_at);
+        UPDATE orders SET customer_id = (SELECT id FROM customers WHERE email = lower(trim(new.customer_email)))
+        WHERE id = new.id;
+    END;
+    CREATE TRIGGER customer_order_delete AFTER DELETE ON orders BEGIN
+        UPDATE customers SET order_count = order_count - 1, total_spent = total_spent - old.total_amount
+        WHERE id = old.customer_id;
+    END;
+)"};
+
+// Order times as integer Unix epoch milliseconds, for range filters and
+// ordering that compare numbers instead of text. The order writer stores
+// the time itself (and derives created_at from it). Other inserts, and
+// later changes to created_at, are converted by trigger. Existing orders
+// are backfilled at second precision. The order listings move from the
+// created_at indexes to created_ms ones.
+inline constexpr dbr::db::Migration order_epoch_times{7, "order epoch times", R"(
+    ALTER TABLE orders ADD COLUMN created_ms INTEGER;
+    UPDATE orders SET created_ms = CAST(strftime('%s', created_at) AS INTEGER) * 1000;
+
+    DROP INDEX IF EXISTS idx_orders_created;
+    DROP INDEX idx_orders_customer;
+    CREATE INDEX idx_orders_created_ms ON orders (created_ms);
+    CREATE INDEX idx_orders_customer ON orders (customer_id, created_ms);
+
+    CREATE TRIGGER order_created_ms_insert AFTER INSERT ON orders
+    WHEN new.created_ms IS NULL BEGIN
+        UPDATE orders SET created_ms = CAST(strftime('%s', new.created_at) AS INTEGER) * 1000
+        WHERE id = new.id;
+    END;
+    CREATE TRIGGER order_created_ms_update AFTER UPDATE OF created_at ON orders
+    WHEN new.created_ms IS old.created_ms BEGIN
+        UPDATE orders SET created_ms = CAST(strftime('%s', new.created_at) AS INTEGER) * 1000
+        WHERE id = new.id;
+    END;
+)"};
+
+inline constexpr std::array all{
+    initial_schema,
+    sample_catalog,
+    dedupe_sample_pets,
+    sales_rollups,
+    order_item_totals,
+    customers,
+    order_epoch_times,
+};
+
+} // namespace migrations
@@ -0,0 +1,96 @@
+#include "order_export.hpp"
+#include "rows.hpp"
+#include "engine/gzip.hpp"
+
+#include <spdlog/spdlog.h>
+#include <sqlite3.h>
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+
+namespace {
+
+// Sends the orders of `stmt` through `writer` in chunks of about
+// `chunk_bytes`, between `prefix` and `suffix`
+template <typename Writer>
+void stream_orders(httplib::Response& res, dbr::db::Statement stmt, Writer writer, bool gzip,
+                   std::size_t chunk_bytes, const char* content_type, const char* prefix, const char* suffix) {
+    struct State {
+        explicit State(Writer w) : writer(std::move(w)) {}
+        dbr::db::Statement stmt;
+        Writer writer;
+        std::optional<dbr::GzipStream> gzip;
+        std::string buffer;
+        std::string compressed;
+        bool started = false;
+    };
+    auto state = std::make_shared<State>(std::move(writer));
+    state->stmt = std::move(stmt);
+    state->buffer.reserve(chunk_bytes + 4096);
+    if (gzip) {
+        state->gzip.emplace();
+        res.set_header("Content-Encoding", "gzip");
+    }
+    res.set_header("Vary", "Accept-Encoding");
+
+    res.set_chunked_content_provider(content_type,
+        [state, chunk_bytes, prefix, suffix](std::size_t, httplib::DataSink& sink) {
+            auto& buf = state->buffer;
+            buf.clear();
+            if (!state->started) {
+                state->started = true;
+                buf += prefix;
+            }
+            bool finished = false;
+            while (buf.size() < chunk_bytes) {
+                int rc = sqlite3_step(state->stmt);
+                if (rc == SQLITE_ROW) {
+                    state->writer.add(state->stmt.get(), buf);
+                    continue;
+                }
+                if (rc != SQLITE_DONE) {
+                    spdlog::error("Order stream failed: {}", sqlite3_errmsg(sqlite3_db_handle(state->stmt)));
+                    return false;
+                }
+                state->writer.finish(buf);
+                buf += suffix;
+                finished = true;
+                break;
+            }
+
+            std::string* out = &buf;
+            if (state->gzip) {
+                state->compressed.clear();
+                if (!state->gzip->write(buf, state->compressed, finished)) {
+                    spdlog::error("Order stream: gzip compression failed");
+                    return false;
+                }
+                out = &state->compressed;
+            }
+            if (!out->empty() && !sink.write(out->data(), out->size())) {
+                return false;
+            }
+            if (finished) {
+                state->stmt.release();
+                sink.done();
+            }
+            return true;
+        },
+        [state](bool) { state->stmt.release(); });
+}
+
+} // namespace
+
+void stream_order_export(httplib::Response& res, dbr::db::Statement stmt, bool gzip,
+                         std::size_t chunk_bytes) {
+    stream_orders(res, std::move(stmt), NestedOrderWriter<OrderHeaderMapper, OrderItemMapper>(true),
+                  gzip, chunk_bytes, "application/x-ndjson", "", "");
+}
+
+void stream_orders_with_items(httplib::Response& res, dbr::db::Statement stmt, bool gzip,
+                              std::size_t chunk_bytes) {
+    stream_orders(res, std::move(stmt), NestedOrderWriter<OrderMapper, OrderItemDetailMapper>(false),
+                  gzip, chunk_bytes, "application/json", "[", "]");
+}
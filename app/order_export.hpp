@@ -0,0 +1,79 @@
+#pragma once
+
+#include "engine/db_connection.hpp"
+
+#include <httplib.h>
+#include <sqlite3.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Assembles nested order objects from the rows of an orders/items join in
+// which each order's rows are consecutive and start with the order id:
+// `Header` maps the order columns and `Item` the item columns after them,
+// which are NULL for an order without items (LEFT JOIN). Each order becomes
+// {<header members>,"items":[..]}, written as its rows go by. With `lines`
+// every order ends with a newline (NDJSON); otherwise orders are separated
+// by commas, for the inside of a JSON array.
+template <typename Header, typename Item>
+class NestedOrderWriter {
+public:
+    explicit NestedOrderWriter(bool lines) : lines_(lines) {}
+
+    // True if `row` belongs to an order other than the one being written
+    bool starts_order(sqlite3_stmt* row) const {
+        return !open_ || sqlite3_column_int64(row, 0) != order_id_;
+    }
+
+    void add(sqlite3_stmt* row, std::string& out) {
+        if (starts_order(row)) {
+            close(out);
+            if (!lines_ && orders_ > 0) out += ',';
+            out += '{';
+            Header::write_members(row, out);
+            out += ",\"items\":[";
+            open_ = true;
+            order_id_ = sqlite3_column_int64(row, 0);
+            has_items_ = false;
+            ++orders_;
+        }
+        if (sqlite3_column_type(row, Header::column_count) != SQLITE_NULL) {
+            if (has_items_) out += ',';
+            Item::write_json(row, out, Header::column_count);
+            has_items_ = true;
+        }
+    }
+
+    // Closes the last order
+    void finish(std::string& out) { close(out); }
+
+    std::size_t orders() const { return orders_; }
+
+private:
+    void close(std::string& out) {
+        if (!open_) return;
+        out += lines_ ? "]}\n" : "]}";
+        open_ = false;
+    }
+
+    bool lines_;
+    bool open_ = false;     // an order is waiting for more items
+    bool has_items_ = false;
+    std::int64_t order_id_ = 0;
+    std::size_t orders_ = 0;
+};
+
+// Streams queries::orders_export as NDJSON: one line per order, holding the
+// order's columns and an "items" array. The join returns an order's items
+// on consecutive rows (ordered by order id), so each order is assembled as
+// its rows go by and memory stays at one chunk however many orders there
+// are. With `gzip` the stream is compressed on the fly and sent with
+// Content-Encoding: gzip.
+void stream_order_export(httplib::Response& res, dbr::db::Statement stmt, bool gzip,
+                         std::size_t chunk_bytes = 64 * 1024);
+
+// Streams queries::orders_with_items as a JSON array of orders, each with
+// its "items", the same way: one scan, one chunk of memory.
+void stream_orders_with_items(httplib::Response& res, dbr::db::Statement stmt, bool gzip,
+                              std::size_t chunk_bytes = 64 * 1024);
@@ -0,0 +1,149 @@
+#include "order_writer.hpp"
+#include "queries.hpp"
+
+#include <spdlog/spdlog.h>
+#include <sqlite3.h>
+
+#include <utility>
+
+namespace {
+
+bool exec(sqlite3* db, const char* sql) {
+    char* err = nullptr;
+    if (sqlite3_exec(db, sql, nullptr, nullptr, &err) != SQLITE_OK) {
+        spdlog::error("{} failed: {}", sql, err ? err : "unknown error");
+        sqlite3_free(err);
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+OrderWriter::OrderWriter(std::shared_ptr<dbr::db::ConnectionPool> db,
+                         std::size_t queue_capacity, std::size_t max_batch)
+    : db_(std::move(db)), capacity_(queue_capacity), max_batch_(max_batch) {
+    thread_ = std::thread([this] { run(); });
+}
+
+OrderWriter::~OrderWriter() {
+    stop();
+}
+
+void OrderWriter::stop() {
+    {
+        std::lock_guard lock(mutex_);
+        if (stopping_) return;
+        stopping_ = true;
+    }
+    not_empty_.notify_all();
+    not_full_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+std::optional<std::future<OrderResult>> OrderWriter::submit(NewOrder order,
+                                                            std::chrono::milliseconds wait) {
+    std::unique_lock lock(mutex_);
+    if (!not_full_.wait_for(lock, wait, [this] { return stopping_ || queue_.size() < capacity_; })
+        || stopping_) {
+        return std::nullopt;
+    }
+    queue_.push_back(Pending{std::move(order), {}});
+    auto future = queue_.back().done.get_future();
+    lock.unlock();
+    not_empty_.notify_one();
+    return future;
+}
+
+void OrderWriter::run() {
+    std::vector<Pending> batch;
+    batch.reserve(max_batch_);
+    for (;;) {
+        {
+            std::unique_lock lock(mutex_);
+            not_empty_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+            if (queue_.empty()) {
+                return; // stopping and fully drained
+            }
+            while (!queue_.empty() && batch.size() < max_batch_) {
+                batch.push_back(std::move(queue_.front()));
+                queue_.pop_front();
+            }
+        }
+        not_full_.notify_all();
+
+        commit_batch(batch);
+        batch.clear();
+    }
+}
+
+void OrderWriter::commit_batch(std::vector<Pending>& batch) {
+    std::vector<OrderResult> results(batch.size());
+    bool committed = false;
+    {
+        auto conn = db_->writer();
+        if (exec(conn, "BEGIN IMMEDIATE")) {
+            for (std::size_t i = 0; i < batch.size(); ++i) {
+                exec(conn, "SAVEPOINT order_insert");
+                results[i] = insert_order(conn, batch[i].order);
+                if (!results[i].ok) {
+                    exec(conn, "ROLLBACK TO order_insert");
+                }
+                exec(conn, "RELEASE order_insert");
+            }
+            committed = exec(conn, "COMMIT");
+            if (!committed) {
+                exec(conn, "ROLLBACK");
+            }
+        }
+    }
+
+    if (batch.size() > 1) {
+        spdlog::debug("Order batch of {} {}", batch.size(), committed ? "committed" : "failed");
+    }
+    for (std::size_t i = 0; i < batch.size(); ++i) {
+        if (!committed) {
+            results[i] = OrderResult{false, 0, "Failed to commit order"};
+        }
+        batch[i].done.set_value(std::move(results[i]));
+    }
+}
+
+OrderResult OrderWriter::insert_order(dbr::db::ConnectionPool::WriteLease& conn,
+                                      const NewOrder& order) {
+    auto stmt = conn.prepare(queries::insert_order);
+    if (!stmt) {
+        return {false, 0, "Failed to create order"};
+    }
+    sqlite3_bind_text(stmt, 1, order.customer_name.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 2, order.customer_email.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 3, order.customer_phone.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_double(stmt, 4, order.total_amount);
+    sqlite3_bind_int64(stmt, 5, std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+    if (sqlite3_step(stmt) != SQLITE_DONE) {
+        spdlog::error("Order insert failed: {}", sqlite3_errmsg(conn));
+        return {false, 0, "Failed to create order"};
+    }
+    std::int64_t order_id = sqlite3_last_insert_rowid(conn);
+
+    auto item_stmt = conn.prepare(queries::insert_order_item);
+    if (!item_stmt) {
+        return {false, 0, "Failed to create order"};
+    }
+    for (auto& item : order.items) {
+        sqlite3_bind_int64(item_stmt, 1, order_id);
+        sqlite3_bind_int64(item_stmt, 2, item.pet_id);
+        sqlite3_bind_int(item_stmt, 3, item.quantity);
+        sqlite3_bind_double(item_stmt, 4, item.price);
+        int rc = sqlite3_step(item_stmt);
+        sqlite3_reset(item_stmt);
+        if (rc != SQLITE_DONE) {
+            spdlog::error("Order item insert failed: {}", sqlite3_errmsg(conn));
+            return {false, 0, "Failed to create order"};
+        }
+    }
+    return {true, order_id, {}};
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "engine/db_pool.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct NewOrderItem {
+    std::int64_t pet_id = 0;
+    int quantity = 1;
+    double price = 0.0;
+};
+
+struct NewOrder {
+    std::string customer_name;
+    std::string customer_email;
+    std::string customer_phone;
+    double total_amount = 0.0;
+    std::vector<NewOrderItem> items;
+};
+
+struct OrderResult {
+    bool ok = false;
+    std::int64_t order_id = 0;
+    std::string error;
+};
+
+// Group-commit writer for POST /api/orders.
+//
+// Requests enqueue their order and wait on a future. A single writer thread
+// drains the queue and commits everything it took in one transaction, so a
+// burst of N checkouts costs one fsync instead of N. Each order runs inside
+// its own savepoint: a failing order is rolled back alone and the rest of
+// the batch still commits. Futures are fulfilled only after COMMIT returns,
+// i.e. once the batch is durable.
+class OrderWriter {
+public:
+    explicit OrderWriter(std::shared_ptr<dbr::db::ConnectionPool> db,
+                         std::size_t queue_capacity = 4096,
+                         std::size_t max_batch = 512);
+    ~OrderWriter();
+    OrderWriter(const OrderWriter&) = delete;
+    OrderWriter& operator=(const OrderWriter&) = delete;
+
+    // Queues an order for the next batch. Returns nullopt if the queue stays
+    // full for longer than `wait` (back-pressure) or the writer is stopped.
+    std::optional<std::future<OrderResult>> submit(NewOrder order,
+                                                   std::chrono::milliseconds wait);
+
+    void stop();
+
+private:
+    struct Pending {
+        NewOrder order;
+        std::promise<OrderResult> done;
+    };
+
+    void run();
+    void commit_batch(std::vector<Pending>& batch);
+    OrderResult insert_order(dbr::db::ConnectionPool::WriteLease& conn, const NewOrder& order);
+
+    std::shared_ptr<dbr::db::ConnectionPool> db_;
+    const std::size_t capacity_;
+    const std::size_t max_batch_;
+
+    std::mutex mutex_;
+    std::condition_variable not_empty_;
+    std::condition_variable not_full_;
+    std::deque<Pending> queue_;
+    bool stopping_ = false;
+    std::thread thread_;
+};
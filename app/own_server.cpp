@@ -1,113 +1,394 @@
 #include "own_server.hpp"
 #include "common_defs.hpp"
+#include "engine/arena.hpp"
+#include "engine/db_stream.hpp"
+#include "engine/etag.hpp"
+#include "queries.hpp"
+#include "migrations.hpp"
+#include "query_plans.hpp"
+#include "cursor.hpp"
+#include "rows.hpp"
+#include "pet_import.hpp"
+#include "order_export.hpp"
+#include "pet_index.hpp"
+#include "engine/gzip.hpp"
 #include <sqlite3.h>
 #include <nlohmann/json.hpp>
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <initializer_list>
+#include <limits>
 #include <memory>
+#include <optional>
+#include <string_view>
 #include <spdlog/spdlog.h>
 
 using json = nlohmann::json;
+// Handler scratch JSON, allocated from the worker's request arena
+using ajson = dbr::arena::json;
 
 
-void init_database(std::shared_ptr<sqlite3> db) {
-    spdlog::debug("Initializing database...");
-    // Create pets table
-    sqlite3_exec(db.get(), R"(
-        CREATE TABLE IF NOT EXISTS pets (
-            id INTEGER PRIMARY KEY AUTOINCREMENT,
-            name TEXT NOT NULL,
-            species TEXT NOT NULL,
-            breed TEXT,
-            age INTEGER,
-            price REAL NOT NULL,
-            description TEXT,
-            image_url TEXT,
-            available BOOLEAN DEFAULT 1,
-            created_at DATETIME DEFAULT CURRENT_TIMESTAMP
-        );
-    )", nullptr, nullptr, nullptr);
-
-    // Create categories table
-    sqlite3_exec(db.get(), R"(
-        CREATE TABLE IF NOT EXISTS categories (
-            id INTEGER PRIMARY KEY AUTOINCREMENT,
-            name TEXT NOT NULL UNIQUE,
-            description TEXT
-        );
-    )", nullptr, nullptr, nullptr);
-
-    // Create pet_categories junction table
-    sqlite3_exec(db.get(), R"(
-        CREATE TABLE IF NOT EXISTS pet_categories (
-            pet_id INTEGER,
-            category_id INTEGER,
-            PRIMARY KEY (pet_id, category_id),
-            FOREIGN KEY (pet_id) REFERENCES pets(id),
-            FOREIGN KEY (category_id) REFERENCES categories(id)
-        );
-    )", nullptr, nullptr, nullptr);
-
-    // Create orders table
-    sqlite3_exec(db.get(), R"(
-        CREATE TABLE IF NOT EXISTS orders (
-            id INTEGER PRIMARY KEY AUTOINCREMENT,
-            customer_name TEXT NOT NULL,
-            customer_email TEXT NOT NULL,
-            customer_phone TEXT,
-            total_amount REAL NOT NULL,
-            status TEXT DEFAULT 'pending',
-            created_at DATETIME DEFAULT CURRENT_TIMESTAMP
-        );
-    )", nullptr, nullptr, nullptr);
-
-    // Create order_items table
-    sqlite3_exec(db.get(), R"(
-        CREATE TABLE IF NOT EXISTS order_items (
-            id INTEGER PRIMARY KEY AUTOINCREMENT,
-            order_id INTEGER,
-            pet_id INTEGER,
-            quantity INTEGER DEFAULT 1,
-            price REAL NOT NULL,
-            FOREIGN KEY (order_id) REFERENCES orders(id),
-            FOREIGN KEY (pet_id) REFERENCES pets(id)
-        );
-    )", nullptr, nullptr, nullptr);
-
-    // Insert sample categories
-    sqlite3_exec(db.get(), R"(
-        INSERT OR IGNORE INTO categories (name, description) VALUES 
-        ('Dogs', 'Loyal and friendly companions'),
-        ('Cats', 'Independent and playful pets'),
-        ('Birds', 'Colorful and musical friends'),
-        ('Fish', 'Peaceful aquatic companions'),
-        ('Small Animals', 'Hamsters, rabbits, and other small pets');
-    )", nullptr, nullptr, nullptr);
-
-    // Insert sample pets
-    sqlite3_exec(db.get(), R"(
-        INSERT OR IGNORE INTO pets (name, species, breed, age, price, description, image_url, available) VALUES 
-        ('Buddy', 'Dog', 'Golden Retriever', 2, 800.00, 'Friendly and energetic golden retriever, great with kids', '/images/golden-retriever.svg', 1),
-        ('Luna', 'Cat', 'Persian', 1, 600.00, 'Beautiful Persian cat with long silky fur', '/images/persian-cat.svg', 1),
-        ('Charlie', 'Dog', 'Labrador', 3, 750.00, 'Well-trained Labrador, perfect family dog', '/images/labrador.svg', 1),
-        ('Whiskers', 'Cat', 'Siamese', 2, 550.00, 'Elegant Siamese cat with striking blue eyes', '/images/siamese-cat.svg', 1),
-        ('Tweety', 'Bird', 'Canary', 1, 150.00, 'Beautiful singing canary with bright yellow feathers', '/images/canary.svg', 1),
-        ('Nemo', 'Fish', 'Goldfish', 1, 25.00, 'Healthy goldfish perfect for beginners', '/images/goldfish.svg', 1),
-        ('Fluffy', 'Small Animal', 'Rabbit', 1, 120.00, 'Adorable rabbit with soft white fur', '/images/rabbit.svg', 1),
-        ('Max', 'Dog', 'German Shepherd', 4, 900.00, 'Intelligent and protective German Shepherd', '/images/german-shepherd.svg', 1),
-        ('Mittens', 'Cat', 'Maine Coon', 2, 700.00, 'Large and gentle Maine Coon cat', '/images/maine-coon.svg', 1),
-        ('Polly', 'Bird', 'Parrot', 3, 400.00, 'Colorful parrot that can learn to speak', '/images/parrot.svg', 1);
-    )", nullptr, nullptr, nullptr);
-
-    // Link pets to categories
-    sqlite3_exec(db.get(), R"(
-        INSERT OR IGNORE INTO pet_categories (pet_id, category_id) VALUES 
-        (1, 1), (3, 1), (8, 1),  -- Dogs
-        (2, 2), (4, 2), (9, 2),  -- Cats
-        (5, 3), (10, 3),         -- Birds
-        (6, 4),                  -- Fish
-        (7, 5);                  -- Small Animals
-    )", nullptr, nullptr, nullptr);
+// Turns free text into an FTS5 query: every word becomes a quoted prefix
+// term ("gold"* "ret"*), all of which must match. Returns an empty string
+// if the input holds no searchable characters.
+std::string fts_match_query(std::string_view text) {
+    std::string query;
+    std::size_t i = 0;
+    while (i < text.size()) {
+        while (i < text.size() && !(std::isalnum(static_cast<unsigned char>(text[i])) || static_cast<unsigned char>(text[i]) >= 0x80)) {
+            ++i;
+        }
+        std::size_t start = i;
+        while (i < text.size() && (std::isalnum(static_cast<unsigned char>(text[i])) || static_cast<unsigned char>(text[i]) >= 0x80)) {
+            ++i;
+        }
+        if (i > start) {
+            if (!query.empty()) query += ' ';
+            query += '"';
+            query.append(text.substr(start, i - start));
+            query += "\"*";
+        }
+    }
+    return query;
+}
+
+// Customer key of an email address, as migrations::customers derives it
+// in SQL (lower(trim(email))): surrounding spaces dropped, ASCII lowercased
+std::string customer_key(std::string_view email) {
+    auto first = email.find_first_not_of(' ');
+    if (first == std::string_view::npos) return {};
+    email = email.substr(first, email.find_last_not_of(' ') - first + 1);
+    std::string key(email);
+    for (auto& c : key) {
+        if (c >= 'A' && c <= 'Z') c = static_cast<char>(c - 'A' + 'a');
+    }
+    return key;
+}
+
+// ?limit= and ?after= of a keyset-paginated listing
+struct PageRequest {
+    std::int64_t limit = -1;    // -1: no limit
+    std::optional<Cursor> after;
+};
+
+constexpr std::int64_t max_page_size = 1000;
+
+// Parses the paging parameters; on malformed input fills a 400 response and
+// returns nullopt.
+std::optional<PageRequest> parse_page_request(const httplib::Request& req, httplib::Response& res) {
+    PageRequest page;
+    if (req.has_param("limit")) {
+        try {
+            page.limit = std::stoll(req.get_param_value("limit"));
+        } catch (const std::exception&) {
+            page.limit = 0;
+        }
+        if (page.limit < 1 || page.limit > max_page_size) {
+            res.status = 400;
+            res.set_content("{\"error\": \"limit must be between 1 and 1000\"}", "application/json");
+            return std::nullopt;
+        }
+    }
+    if (req.has_param("after")) {
+        page.after = decode_cursor(req.get_param_value("after"));
+        if (!page.after) {
+            res.status = 400;
+            res.set_content("{\"error\": \"Invalid cursor\"}", "application/json");
+            return std::nullopt;
+        }
+    }
+    return page;
+}
+
+// Time in epoch milliseconds: an integer number of milliseconds, a date
+// (YYYY-MM-DD, midnight UTC) or a UTC date and time (YYYY-MM-DDTHH:MM:SS,
+// optionally ending in Z; a space may stand for the T, as in created_at)
+std::optional<std::int64_t> parse_time_ms(std::string_view text) {
+    std::int64_t value;
+    auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (ec == std::errc() && end == text.data() + text.size()) {
+        return value;
+    }
+    if (text.ends_with('Z')) text.remove_suffix(1);
+    bool with_time = text.size() == 19;
+    if ((text.size() != 10 && !with_time) || text[4] != '-' || text[7] != '-'
+        || (with_time && ((text[10] != 'T' && text[10] != ' ') || text[13] != ':' || text[16] != ':'))) {
+        return std::nullopt;
+    }
+    auto field = [&](std::size_t pos, std::size_t len, int& out) {
+        auto [end, ec] = std::from_chars(text.data() + pos, text.data() + pos + len, out);
+        return ec == std::errc() && end == text.data() + pos + len;
+    };
+    int y, mo, d, h = 0, mi = 0, sec = 0;
+    if (!field(0, 4, y) || !field(5, 2, mo) || !field(8, 2, d)) return std::nullopt;
+    if (with_time && (!field(11, 2, h) || !field(14, 2, mi) || !field(17, 2, sec))) return std::nullopt;
+    std::chrono::year_month_day date{std::chrono::year(y), std::chrono::month(mo), std::chrono::day(d)};
+    if (!date.ok() || h > 23 || mi > 59 || sec > 59) return std::nullopt;
+    auto time = std::chrono::sys_days(date) + std::chrono::hours(h) + std::chrono::minutes(mi)
+              + std::chrono::seconds(sec);
+    return std::chrono::duration_cast<std::chrono::milliseconds>(time.time_since_epoch()).count();
+}
+
+// ?from= and ?to= of the order listing: orders created at or after `from`
+// and before `to` (see parse_time_ms), in epoch milliseconds
+struct TimeRange {
+    std::int64_t from = std::numeric_limits<std::int64_t>::min();
+    std::int64_t to = std::numeric_limits<std::int64_t>::max();
+
+    // Inclusive upper bound of a page's index range: the last millisecond
+    // before `to`, but no later than the cursor's created_ms
+    std::int64_t last(std::int64_t cursor_ms) const {
+        return std::min(to == std::numeric_limits<std::int64_t>::min() ? to : to - 1, cursor_ms);
+    }
+};
+
+// Parses the range; on malformed input fills a 400 response and returns
+// nullopt.
+std::optional<TimeRange> parse_time_range(const httplib::Request& req, httplib::Response& res) {
+    TimeRange range;
+    for (auto [name, out] : {std::pair{"from", &range.from}, std::pair{"to", &range.to}}) {
+        if (!req.has_param(name)) continue;
+        auto value = parse_time_ms(req.get_param_value(name));
+        if (!value) {
+            res.status = 400;
+            res.set_content("{\"error\": \"from and to must be epoch milliseconds or UTC dates (YYYY-MM-DD[THH:MM:SS])\"}",
+                            "application/json");
+            return std::nullopt;
+        }
+        *out = *value;
+    }
+    return range;
+}
+
+// Integer parameter `name` in [lo, hi], or `fallback` if absent. Returns
+// nullopt if it is malformed or out of range.
+std::optional<std::int64_t> int_param(const httplib::Request& req, const char* name,
+                                      std::int64_t fallback, std::int64_t lo, std::int64_t hi) {
+    if (!req.has_param(name)) {
+        return fallback;
+    }
+    std::int64_t value;
+    auto text = req.get_param_value(name);
+    auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (ec != std::errc() || end != text.data() + text.size() || value < lo || value > hi) {
+        return std::nullopt;
+    }
+    return value;
+}
+
+// Listing filters of /api/pets: ?category=, ?species=, ?available= (true,
+// false or any; default true), ?min_price=, ?max_price=, ?min_age=,
+// ?max_age= and ?sort= (newest, price_asc or price_desc). On malformed
+// input fills a 400 response and returns nullopt.
+std::optional<PetFilter> parse_pet_filter(const httplib::Request& req, httplib::Response& res) {
+    auto invalid = [&](const char* message) {
+        res.status = 400;
+        res.set_content(std::string("{\"error\": \"") + message + "\"}", "application/json");
+        return std::nullopt;
+    };
+    auto price = [&](const char* name, std::optional<double>& out) {
+        if (!req.has_param(name)) return true;
+        double value;
+        auto text = req.get_param_value(name);
+        auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+        if (ec != std::errc() || end != text.data() + text.size() || !(value >= 0) || std::isinf(value)) {
+            return false;
+        }
+        out = value;
+        return true;
+    };
+    auto age = [&](const char* name, std::optional<std::int32_t>& out) {
+        if (!req.has_param(name)) return true;
+        auto value = int_param(req, name, 0, 0, 1000);
+        if (value) out = static_cast<std::int32_t>(*value);
+        return value.has_value();
+    };
+
+    PetFilter filter;
+    if (req.has_param("category")) filter.category = req.get_param_value("category");
+    if (req.has_param("species")) filter.species = req.get_param_value("species");
+    if (req.has_param("available")) {
+        auto value = req.get_param_value("available");
+        if (value == "true" || value == "1") filter.available = true;
+        else if (value == "false" || value == "0") filter.available = false;
+        else if (value == "any") filter.available = std::nullopt;
+        else return invalid("available must be true, false or any");
+    }
+    if (!price("min_price", filter.min_price) || !price("max_price", filter.max_price)) {
+        return invalid("min_price and max_price must be non-negative numbers");
+    }
+    if (!age("min_age", filter.min_age) || !age("max_age", filter.max_age)) {
+        return invalid("min_age and max_age must be between 0 and 1000");
+    }
+    if (req.has_param("sort")) {
+        auto value = req.get_param_value("sort");
+        if (value == "newest") filter.sort = PetSort::Newest;
+        else if (value == "price_asc") filter.sort = PetSort::PriceAsc;
+        else if (value == "price_desc") filter.sort = PetSort::PriceDesc;
+        else return invalid("sort must be newest, price_asc or price_desc");
+    }
+    return filter;
+}
+
+// Appends the statement's rows as a JSON array
+template <typename Mapper>
+bool append_rows(std::string& body, dbr::db::Statement stmt) {
+    if (!stmt) return false;
+    body += '[';
+    int rc;
+    bool first = true;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        if (!first) body += ',';
+        first = false;
+        Mapper::write_json(stmt.get(), body);
+    }
+    body += ']';
+    return rc == SQLITE_DONE;
+}
+
+// One extra row is fetched to learn whether another page follows
+std::int64_t limit_with_lookahead(const PageRequest& page) {
+    return page.limit < 0 ? -1 : page.limit + 1;
+}
+
+void set_next_cursor(httplib::Response& res, const std::string& cursor) {
+    res.set_header("X-Next-Cursor", cursor);
+    res.set_header("Access-Control-Expose-Headers", "X-Next-Cursor");
+}
+
+// created_ms of the order-listing cursor (the largest value without one).
+// Fills a 400 response and returns nullopt if the key is not a number, as
+// in cursors issued before the listings were keyed on created_ms.
+std::optional<std::int64_t> order_cursor_ms(const PageRequest& page, httplib::Response& res) {
+    if (!page.after) {
+        return std::numeric_limits<std::int64_t>::max();
+    }
+    std::int64_t ms;
+    auto& key = page.after->key;
+    auto [end, ec] = std::from_chars(key.data(), key.data() + key.size(), ms);
+    if (ec != std::errc() || end != key.data() + key.size()) {
+        res.status = 400;
+        res.set_content("{\"error\": \"Invalid cursor\"}", "application/json");
+        return std::nullopt;
+    }
+    return ms;
+}
+
+// Numeric key of a cursor (search rank, price); replies 400 unless the
+// whole key is a finite number
+std::optional<double> cursor_number(const Cursor& after, httplib::Response& res) {
+    double value;
+    auto& key = after.key;
+    auto [end, ec] = std::from_chars(key.data(), key.data() + key.size(), value);
+    if (ec != std::errc() || end != key.data() + key.size() || !std::isfinite(value)) {
+        res.status = 400;
+        res.set_content("{\"error\": \"Invalid cursor\"}", "application/json");
+        return std::nullopt;
+    }
+    return value;
+}
+
+// Conditional GET: tags the response with the data version of `tables` and,
+// if the client already holds that version, answers 304 without running the
+// query. Returns true when the request has been answered.
+bool not_modified(const httplib::Request& req, httplib::Response& res, dbr::db::ConnectionPool& db,
+                  std::initializer_list<std::string_view> tables) {
+    auto etag = dbr::make_etag(db.epoch(), db.version(tables), req);
+    res.set_header("ETag", etag);
+    res.set_header("Cache-Control", "no-cache");
+    if (dbr::etag_matches(req, etag)) {
+        res.status = 304;
+        return true;
+    }
+    return false;
 }
 
+// /api/orders?expand=items: orders newest first, each with its items, from
+// one stepped join (queries::orders_with_items). A page stops stepping at
+// the first row of the order after it; without a limit the listing is
+// streamed.
+void serve_orders_with_items(const httplib::Request& req, httplib::Response& res, dbr::db::ConnectionPool& db,
+                             const PageRequest& page, std::int64_t after_ms, const TimeRange& range) {
+    if (not_modified(req, res, db, {"orders", "order_items", "pets"})) return;
+    auto stmt = db.reader().prepare(page.after ? queries::orders_with_items_after : queries::orders_with_items);
+    if (!stmt) {
+        res.status = 500;
+        res.set_content("{\"error\": \"Database error\"}", "application/json");
+        return;
+    }
+    if (page.after) {
+        sqlite3_bind_int64(stmt, 1, after_ms);
+        sqlite3_bind_int64(stmt, 2, page.after->id);
+    }
+    sqlite3_bind_int64(stmt, 3, range.from);
+    sqlite3_bind_int64(stmt, 4, range.last(after_ms));
+
+    if (page.limit < 0) {
+        stream_orders_with_items(res, std::move(stmt), dbr::accepts_gzip(req.get_header_value("Accept-Encoding")));
+        return;
+    }
+
+    NestedOrderWriter<OrderMapper, OrderItemDetailMapper> writer(false);
+    std::string body = "[";
+    std::int64_t last_ms = 0;
+    std::int64_t last_id = 0;
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        if (writer.starts_order(stmt.get())) {
+            if (static_cast<std::int64_t>(writer.orders()) == page.limit) {
+                set_next_cursor(res, encode_cursor(std::to_string(last_ms), last_id));
+                rc = SQLITE_DONE;
+                break;
+            }
+            last_id = sqlite3_column_int64(stmt, 0);
+            last_ms = sqlite3_column_int64(stmt, 7);
+        }
+        writer.add(stmt.get(), body);
+    }
+    if (rc != SQLITE_DONE) {
+        res.status = 500;
+        res.set_content("{\"error\": \"Database error\"}", "application/json");
+        return;
+    }
+    writer.finish(body);
+    body += ']';
+    res.set_content(std::move(body), "application/json");
+}
+
+json backup_progress_json(const dbr::db::BackupProgress& progress) {
+    json j;
+    j["state"] = dbr::db::BackupProgress::state_name(progress.state);
+    j["path"] = progress.path;
+    j["pages_total"] = progress.pages_total;
+    j["pages_remaining"] = progress.pages_remaining;
+    j["bytes_copied"] = progress.bytes_copied;
+    j["elapsed_seconds"] = progress.elapsed_seconds;
+    j["bytes_per_second"] = progress.bytes_per_second;
+    j["finished_at"] = progress.finished_at;
+    if (!progress.error.empty()) {
+        j["error"] = progress.error;
+    }
+    return j;
+}
+
+json maintenance_json(const dbr::db::MaintenanceStats& stats) {
+    using Stats = dbr::db::MaintenanceStats;
+    json j;
+    for (int i = 0; i < Stats::TaskCount; ++i) {
+        auto& task = stats.tasks[i];
+        auto& out = j["tasks"][Stats::task_name(static_cast<Stats::Task>(i))];
+        out["runs"] = task.runs;
+        out["last_run_at"] = task.last_run_at;
+        out["last_seconds"] = task.last_seconds;
+        out["last_result"] = task.last_result;
+    }
+    j["deferred"] = stats.deferred;
+    return j;
+}
 
 
 dbr::ErrorCode OwnServer::own_configure(httplib::Server& srv) {
@@ -126,209 +407,539 @@ dbr::ErrorCode OwnServer::own_configure(httplib::Server& srv) {
     });
 
 
-    sqlite3* db__;
-    sqlite3_open("petstore.db", &db__);
-    std::shared_ptr<sqlite3> dbptr{db__, sqlite3_close};
-    init_database(dbptr);
-
-    // Get all pets with optional filtering
-    srv.Get("/api/pets", [dbptr](const Request& req, Response& res) {
-        std::string query = R"(
-            SELECT p.*, GROUP_CONCAT(c.name) as categories
-            FROM pets p
-            LEFT JOIN pet_categories pc ON p.id = pc.pet_id
-            LEFT JOIN categories c ON pc.category_id = c.id
-            WHERE p.available = 1
-        )";
-        
-        // Add filtering by category
-        if (req.has_param("category")) {
-            query += " AND c.name = ?";
+    db_ = std::make_shared<dbr::db::ConnectionPool>(dbr::db::PoolOptions{.path = "petstore.db"});
+    if (!db_->open()) {
+        return dbr::ErrorCode::UnknownError;
+    }
+    if (!dbr::db::migrate(db_->writer(), migrations::all)) {
+        return dbr::ErrorCode::UnknownError;
+    }
+#ifndef NDEBUG
+    // The query_plan_check test is the gate; this only points at the culprit
+    if (auto scans = check_query_plans(db_->writer()); scans > 0) {
+        spdlog::error("Query-plan check: {} full scan(s) in API queries", scans);
+    }
+#endif
+    order_writer_ = std::make_shared<OrderWriter>(db_);
+    std::shared_ptr<dbr::db::MemoryReplica> replica;
+    if (options_.catalog_in_memory) {
+        replica = std::make_shared<dbr::db::MemoryReplica>(
+            db_, std::vector<std::string>{"categories", "pets", "pet_categories", "pets_fts"});
+        if (!replica->load()) {
+            spdlog::warn("Cannot copy the catalog into memory; reading it from {}", db_->options().path);
+            replica.reset();
         }
-        
-        // Add search by name/breed
-        if (req.has_param("search")) {
-            query += " AND (p.name LIKE ? OR p.breed LIKE ? OR p.species LIKE ?)";
+    }
+    catalog_ = std::make_shared<CatalogCache>(db_, replica);
+    backup_ = std::make_shared<dbr::db::BackupRunner>(db_, dbr::db::BackupOptions{
+        .path = "petstore.backup.db",
+        .interval = std::chrono::hours(24),
+    });
+    maintenance_ = std::make_shared<dbr::db::MaintenanceScheduler>(db_, dbr::db::MaintenanceOptions{});
+    db_->on_change([catalog = std::weak_ptr(catalog_)](const std::vector<std::string>& tables) {
+        auto cache = catalog.lock();
+        if (cache && std::any_of(tables.begin(), tables.end(), CatalogCache::covers)) {
+            cache->invalidate();
         }
-        
-        query += " GROUP BY p.id ORDER BY p.created_at DESC";
-        
-        sqlite3_stmt* stmt;
-        json pets = json::array();
-        
-        if (sqlite3_prepare_v2(dbptr.get(), query.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
-            int param_idx = 1;
-            
-            if (req.has_param("category")) {
-                sqlite3_bind_text(stmt, param_idx++, req.get_param_value("category").c_str(), -1, SQLITE_TRANSIENT);
+    });
+    auto db = db_;
+    auto orders = order_writer_;
+    auto catalog = catalog_;
+
+    // Get all pets with optional filtering. Paginated with ?limit=&after=.
+    // Listings are served from the catalog cache, filtered and sorted on its
+    // columnar PetIndex; searches, or everything if the cache cannot load,
+    // query SQLite (the in-memory catalog copy when enabled; streamed row by
+    // row without a limit).
+    srv.Get("/api/pets", [db, catalog](const Request& req, Response& res) {
+        auto page = parse_page_request(req, res);
+        if (!page) return;
+        auto filter = parse_pet_filter(req, res);
+        if (!filter) return;
+        std::string search = fts_match_query(req.get_param_value("search"));
+        bool by_category = filter->category.has_value();
+        bool by_search = !search.empty();
+
+        if (by_search && req.has_param("sort")) {
+            res.status = 400;
+            res.set_content("{\"error\": \"Search results are ordered by relevance\"}", "application/json");
+            return;
+        }
+        // Search pages are keyed on rank, price-ordered pages on price
+        std::optional<double> after_rank;
+        if (page->after && (by_search || filter->sort != PetSort::Newest)) {
+            after_rank = cursor_number(*page->after, res);
+            if (!after_rank) return;
+        }
+        if (not_modified(req, res, *db, {"pets", "categories", "pet_categories"})) return;
+        if (!by_search) {
+            if (auto snap = catalog->snapshot()) {
+                std::optional<Cursor> next;
+                res.set_content(snap->query(*filter, page->after, page->limit, next), "application/json");
+                if (next) {
+                    set_next_cursor(res, encode_cursor(next->key, next->id));
+                }
+                return;
             }
-            
-            if (req.has_param("search")) {
-                std::string search = "%" + req.get_param_value("search") + "%";
-                sqlite3_bind_text(stmt, param_idx++, search.c_str(), -1, SQLITE_TRANSIENT);
-                sqlite3_bind_text(stmt, param_idx++, search.c_str(), -1, SQLITE_TRANSIENT);
-                sqlite3_bind_text(stmt, param_idx++, search.c_str(), -1, SQLITE_TRANSIENT);
+            // The SQL listings walk the available pets newest first
+            if (filter->available != true || filter->sort != PetSort::Newest) {
+                res.status = 503;
+                res.set_content("{\"error\": \"Catalog unavailable\"}", "application/json");
+                return;
             }
-            
-            while (sqlite3_step(stmt) == SQLITE_ROW) {
-                json pet;
-                pet["id"] = sqlite3_column_int(stmt, 0);
-                pet["name"] = (const char*)sqlite3_column_text(stmt, 1);
-                pet["species"] = (const char*)sqlite3_column_text(stmt, 2);
-                pet["breed"] = sqlite3_column_text(stmt, 3) ? (const char*)sqlite3_column_text(stmt, 3) : "";
-                pet["age"] = sqlite3_column_int(stmt, 4);
-                pet["price"] = sqlite3_column_double(stmt, 5);
-                pet["description"] = sqlite3_column_text(stmt, 6) ? (const char*)sqlite3_column_text(stmt, 6) : "";
-                pet["image_url"] = sqlite3_column_text(stmt, 7) ? (const char*)sqlite3_column_text(stmt, 7) : "";
-                pet["available"] = sqlite3_column_int(stmt, 8) == 1;
-                pet["created_at"] = (const char*)sqlite3_column_text(stmt, 9);
-                pet["categories"] = sqlite3_column_text(stmt, 10) ? (const char*)sqlite3_column_text(stmt, 10) : "";
-                pets.push_back(pet);
+        }
+
+        auto& conn = catalog->reader();
+        auto stmt = conn.prepare(queries::pets(by_category, by_search, page->after.has_value()));
+        if (!stmt) {
+            res.status = 500;
+            res.set_content("{\"error\": \"Database error\"}", "application/json");
+            return;
+        }
+        if (by_category) {
+            sqlite3_bind_text(stmt, 1, filter->category->c_str(), -1, SQLITE_TRANSIENT);
+        }
+        if (by_search) {
+            sqlite3_bind_text(stmt, 2, search.c_str(), -1, SQLITE_TRANSIENT);
+            if (filter->available) {
+                sqlite3_bind_int(stmt, 6, *filter->available ? 1 : 0);
+            }
+        }
+        if (filter->species) sqlite3_bind_text(stmt, 7, filter->species->c_str(), -1, SQLITE_TRANSIENT);
+        if (filter->min_price) sqlite3_bind_double(stmt, 8, *filter->min_price);
+        if (filter->max_price) sqlite3_bind_double(stmt, 9, *filter->max_price);
+        if (filter->min_age) sqlite3_bind_int(stmt, 10, *filter->min_age);
+        if (filter->max_age) sqlite3_bind_int(stmt, 11, *filter->max_age);
+        sqlite3_bind_int64(stmt, 3, limit_with_lookahead(*page));
+        if (page->after) {
+            if (by_search) {
+                sqlite3_bind_double(stmt, 4, *after_rank);
+            } else {
+                sqlite3_bind_text(stmt, 4, page->after->key.c_str(), -1, SQLITE_TRANSIENT);
+            }
+            sqlite3_bind_int64(stmt, 5, page->after->id);
+        }
+
+        if (page->limit < 0) {
+            dbr::db::stream_json_array(res, std::move(stmt), [](sqlite3_stmt* row, std::string& out) {
+                PetMapper::write_json(row, out);
+            });
+            return;
+        }
+
+        std::string body = "[";
+        std::string last_key;
+        std::int64_t last_id = 0;
+        std::int64_t rows = 0;
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            if (rows++ == page->limit) {
+                set_next_cursor(res, encode_cursor(last_key, last_id));
+                break;
             }
+            if (rows > 1) body += ',';
+            PetMapper::write_json(stmt.get(), body);
+            last_id = sqlite3_column_int64(stmt, 0);
+            if (by_search) {
+                char key[32];
+                std::snprintf(key, sizeof(key), "%.17g", sqlite3_column_double(stmt, 11));
+                last_key = key;
+            } else {
+                last_key = (const char*)sqlite3_column_text(stmt, 9);
+            }
+        }
+        body += ']';
+        res.set_content(std::move(body), "application/json");
+    });
+
+    // Autocomplete for the search box: up to ?limit= (default 10) pet names,
+    // breeds and species with a word starting with ?q=, most common first,
+    // from the catalog snapshot's prefix index
+    srv.Get("/api/suggest", [db, catalog](const Request& req, Response& res) {
+        auto limit = int_param(req, "limit", 10, 1, 50);
+        if (!limit) {
+            res.status = 400;
+            res.set_content("{\"error\": \"limit must be between 1 and 50\"}", "application/json");
+            return;
         }
-        sqlite3_finalize(stmt);
-        res.set_content(pets.dump(), "application/json");
+        if (not_modified(req, res, *db, {"pets"})) return;
+        auto snap = catalog->snapshot();
+        if (!snap) {
+            res.status = 503;
+            res.set_content("{\"error\": \"Catalog unavailable\"}", "application/json");
+            return;
+        }
+        std::string body;
+        snap->suggest.top(req.get_param_value("q"), static_cast<std::size_t>(*limit), body);
+        res.set_content(std::move(body), "application/json");
+    });
+
+    // Facet counts for the sidebar: pets per category, species and
+    // availability among those matching the /api/pets filters and ?search=.
+    // Each group is counted without its own filter.
+    srv.Get("/api/facets", [db, catalog](const Request& req, Response& res) {
+        auto filter = parse_pet_filter(req, res);
+        if (!filter || not_modified(req, res, *db, {"pets", "categories", "pet_categories"})) return;
+        auto snap = catalog->snapshot();
+        if (!snap) {
+            res.status = 503;
+            res.set_content("{\"error\": \"Catalog unavailable\"}", "application/json");
+            return;
+        }
+
+        std::optional<std::vector<std::int64_t>> hits;
+        std::string search = fts_match_query(req.get_param_value("search"));
+        if (!search.empty()) {
+            auto stmt = catalog->reader().prepare(queries::search_pet_ids);
+            int rc = SQLITE_ERROR;
+            if (stmt) {
+                sqlite3_bind_text(stmt, 1, search.c_str(), -1, SQLITE_TRANSIENT);
+                hits.emplace();
+                while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+                    hits->push_back(sqlite3_column_int64(stmt, 0));
+                }
+            }
+            if (rc != SQLITE_DONE) {
+                res.status = 500;
+                res.set_content("{\"error\": \"Database error\"}", "application/json");
+                return;
+            }
+        }
+        res.set_content(snap->facet_counts(*filter, hits ? &*hits : nullptr), "application/json");
     });
 
     // Get single pet by ID
-    srv.Get("/api/pets/(\\d+)", [dbptr](const Request& req, Response& res) {
+    srv.Get("/api/pets/(\\d+)", [db, catalog](const Request& req, Response& res) {
+        if (not_modified(req, res, *db, {"pets", "categories", "pet_categories"})) return;
         int pet_id = std::stoi(req.matches[1]);
-        sqlite3_stmt* stmt;
-        json pet;
-        
-        const char* query = R"(
-            SELECT p.*, GROUP_CONCAT(c.name) as categories
-            FROM pets p
-            LEFT JOIN pet_categories pc ON p.id = pc.pet_id
-            LEFT JOIN categories c ON pc.category_id = c.id
-            WHERE p.id = ?
-            GROUP BY p.id
-        )";
-        
-        if (sqlite3_prepare_v2(dbptr.get(), query, -1, &stmt, nullptr) == SQLITE_OK) {
+        std::string body;
+
+        if (auto snap = catalog->snapshot()) {
+            if (auto pet = snap->find(pet_id)) {
+                body = pet->json;
+            }
+        } else if (auto stmt = catalog->reader().prepare(queries::pet_by_id)) {
             sqlite3_bind_int(stmt, 1, pet_id);
             
             if (sqlite3_step(stmt) == SQLITE_ROW) {
-                pet["id"] = sqlite3_column_int(stmt, 0);
-                pet["name"] = (const char*)sqlite3_column_text(stmt, 1);
-                pet["species"] = (const char*)sqlite3_column_text(stmt, 2);
-                pet["breed"] = sqlite3_column_text(stmt, 3) ? (const char*)sqlite3_column_text(stmt, 3) : "";
-                pet["age"] = sqlite3_column_int(stmt, 4);
-                pet["price"] = sqlite3_column_double(stmt, 5);
-                pet["description"] = sqlite3_column_text(stmt, 6) ? (const char*)sqlite3_column_text(stmt, 6) : "";
-                pet["image_url"] = sqlite3_column_text(stmt, 7) ? (const char*)sqlite3_column_text(stmt, 7) : "";
-                pet["available"] = sqlite3_column_int(stmt, 8) == 1;
-                pet["created_at"] = (const char*)sqlite3_column_text(stmt, 9);
-                pet["categories"] = sqlite3_column_text(stmt, 10) ? (const char*)sqlite3_column_text(stmt, 10) : "";
+                PetMapper::write_json(stmt.get(), body);
             }
         }
-        sqlite3_finalize(stmt);
         
-        if (pet.empty()) {
+        if (body.empty()) {
             res.status = 404;
             res.set_content("{\"error\": \"Pet not found\"}", "application/json");
         } else {
-            res.set_content(pet.dump(), "application/json");
+            res.set_content(std::move(body), "application/json");
         }
     });
 
     // Get all categories
-    srv.Get("/api/categories", [dbptr](const Request& req, Response& res) {
-        sqlite3_stmt* stmt;
-        json categories = json::array();
-        
-        const char* query = "SELECT id, name, description FROM categories ORDER BY name";
+    srv.Get("/api/categories", [db, catalog](const Request& req, Response& res) {
+        if (not_modified(req, res, *db, {"categories"})) return;
+        if (auto snap = catalog->snapshot()) {
+            res.set_content(snap->categories_json, "application/json");
+            return;
+        }
+        auto& conn = catalog->reader();
+        std::string body = "[";
         
-        if (sqlite3_prepare_v2(dbptr.get(), query, -1, &stmt, nullptr) == SQLITE_OK) {
+        if (auto stmt = conn.prepare(queries::categories)) {
             while (sqlite3_step(stmt) == SQLITE_ROW) {
-                json category;
-                category["id"] = sqlite3_column_int(stmt, 0);
-                category["name"] = (const char*)sqlite3_column_text(stmt, 1);
-                category["description"] = sqlite3_column_text(stmt, 2) ? (const char*)sqlite3_column_text(stmt, 2) : "";
-                categories.push_back(category);
+                if (body.size() > 1) body += ',';
+                CategoryMapper::write_json(stmt.get(), body);
             }
         }
-        sqlite3_finalize(stmt);
-        res.set_content(categories.dump(), "application/json");
+        body += ']';
+        res.set_content(std::move(body), "application/json");
     });
 
-    // Create new order
-    srv.Post("/api/orders", [dbptr](const Request& req, Response& res) {
-        auto order_data = json::parse(req.body);
-        
-        sqlite3_stmt* stmt;
-        const char* query = R"(
-            INSERT INTO orders (customer_name, customer_email, customer_phone, total_amount, status)
-            VALUES (?, ?, ?, ?, 'pending')
-        )";
-        
-        if (sqlite3_prepare_v2(dbptr.get(), query, -1, &stmt, nullptr) == SQLITE_OK) {
-            sqlite3_bind_text(stmt, 1, order_data["customer_name"].get<std::string>().c_str(), -1, SQLITE_TRANSIENT);
-            sqlite3_bind_text(stmt, 2, order_data["customer_email"].get<std::string>().c_str(), -1, SQLITE_TRANSIENT);
-            sqlite3_bind_text(stmt, 3, order_data["customer_phone"].get<std::string>().c_str(), -1, SQLITE_TRANSIENT);
-            sqlite3_bind_double(stmt, 4, order_data["total_amount"].get<double>());
-            
-            if (sqlite3_step(stmt) == SQLITE_DONE) {
-                int order_id = sqlite3_last_insert_rowid(dbptr.get());
-                
-                // Insert order items
-                for (auto& item : order_data["items"]) {
-                    sqlite3_stmt* item_stmt;
-                    const char* item_query = "INSERT INTO order_items (order_id, pet_id, quantity, price) VALUES (?, ?, ?, ?)";
-                    
-                    if (sqlite3_prepare_v2(dbptr.get(), item_query, -1, &item_stmt, nullptr) == SQLITE_OK) {
-                        sqlite3_bind_int(item_stmt, 1, order_id);
-                        sqlite3_bind_int(item_stmt, 2, item["pet_id"].get<int>());
-                        sqlite3_bind_int(item_stmt, 3, item["quantity"].get<int>());
-                        sqlite3_bind_double(item_stmt, 4, item["price"].get<double>());
-                        sqlite3_step(item_stmt);
-                    }
-                    sqlite3_finalize(item_stmt);
-                }
-                
-                json response;
-                response["order_id"] = order_id;
-                response["status"] = "success";
-                res.set_content(response.dump(), "application/json");
-            } else {
-                res.status = 500;
-                res.set_content("{\"error\": \"Failed to create order\"}", "application/json");
+    // Bulk import of pets from an NDJSON or CSV body (?format=csv or a
+    // text/csv Content-Type; NDJSON otherwise), parsed as it streams in.
+    // Replies with the totals once the body has been consumed.
+    srv.Post("/api/pets/import", [db](const Request& req, Response& res, const ContentReader& content_reader) {
+        bool csv = req.get_param_value("format") == "csv"
+            || req.get_header_value("Content-Type").find("csv") != std::string::npos;
+        PetImporter importer(db, csv ? PetImporter::Format::Csv : PetImporter::Format::Ndjson);
+        content_reader([&](const char* data, std::size_t length) {
+            return importer.feed(std::string_view(data, length));
+        });
+        ImportStats stats = importer.finish();
+
+        json summary;
+        summary["records"] = stats.records;
+        summary["imported"] = stats.imported;
+        summary["rejected"] = stats.rejected;
+        summary["batches"] = stats.batches;
+        summary["seconds"] = stats.seconds;
+        summary["records_per_second"] = stats.seconds > 0 ? stats.records / stats.seconds : 0.0;
+        summary["errors"] = stats.errors;
+        if (!stats.fatal.empty()) {
+            summary["error"] = stats.fatal;
+            res.status = stats.bad_input ? 400 : 500;
+        }
+        res.set_content(summary.dump(), "application/json");
+    });
+
+    // Create new order (queued for the next group commit)
+    srv.Post("/api/orders", [orders](const Request& req, Response& res) {
+        NewOrder order;
+        try {
+            dbr::arena::Scope scope;
+            auto order_data = ajson::parse(req.body);
+            order.customer_name = order_data.at("customer_name").get<std::string>();
+            order.customer_email = order_data.at("customer_email").get<std::string>();
+            order.customer_phone = order_data.value("customer_phone", "");
+            order.total_amount = order_data.at("total_amount").get<double>();
+            for (auto& item : order_data.at("items")) {
+                order.items.push_back(NewOrderItem{
+                    .pet_id = item.at("pet_id").get<std::int64_t>(),
+                    .quantity = item.at("quantity").get<int>(),
+                    .price = item.at("price").get<double>(),
+                });
             }
+        } catch (const nlohmann::json::exception& e) {
+            res.status = 400;
+            res.set_content("{\"error\": \"Invalid order\"}", "application/json");
+            return;
+        }
+
+        auto pending = orders->submit(std::move(order), std::chrono::seconds(5));
+        if (!pending) {
+            res.status = 503;
+            res.set_content("{\"error\": \"Order queue is full\"}", "application/json");
+            return;
+        }
+
+        OrderResult result = pending->get();
+        if (result.ok) {
+            json response;
+            response["order_id"] = result.order_id;
+            response["status"] = "success";
+            res.set_content(response.dump(), "application/json");
+        } else {
+            res.status = 500;
+            res.set_content("{\"error\": \"Failed to create order\"}", "application/json");
         }
-        sqlite3_finalize(stmt);
     });
 
-    // Get orders (for admin)
-    srv.Get("/api/orders", [dbptr](const Request& req, Response& res) {
-        sqlite3_stmt* stmt;
-        json orders = json::array();
+    // Get orders (for admin). Paginated with ?limit=&after=; without a limit
+    // the whole listing is streamed row by row. ?from=&to= restrict it to a
+    // creation-time range (see parse_time_range). ?expand=items nests each
+    // order's items (with pet names), read by the same single scan.
+    srv.Get("/api/orders", [db](const Request& req, Response& res) {
+        auto expand = req.get_param_value("expand");
+        if (!expand.empty() && expand != "items") {
+            res.status = 400;
+            res.set_content("{\"error\": \"expand must be items\"}", "application/json");
+            return;
+        }
+        auto page = parse_page_request(req, res);
+        if (!page) return;
+        auto after_ms = order_cursor_ms(*page, res);
+        auto range = parse_time_range(req, res);
+        if (!after_ms || !range) return;
+        if (!expand.empty()) {
+            serve_orders_with_items(req, res, *db, *page, *after_ms, *range);
+            return;
+        }
+        if (not_modified(req, res, *db, {"orders", "order_items"})) return;
+        auto& conn = db->reader();
         
-        const char* query = R"(
-            SELECT o.*, COUNT(oi.id) as item_count
-            FROM orders o
-            LEFT JOIN order_items oi ON o.id = oi.order_id
-            GROUP BY o.id
-            ORDER BY o.created_at DESC
-        )";
-
-        if (sqlite3_prepare_v2(dbptr.get(), query, -1, &stmt, nullptr) == SQLITE_OK) {
-            while (sqlite3_step(stmt) == SQLITE_ROW) {
-                json order;
-                order["id"] = sqlite3_column_int(stmt, 0);
-                order["customer_name"] = (const char*)sqlite3_column_text(stmt, 1);
-                order["customer_email"] = (const char*)sqlite3_column_text(stmt, 2);
-                order["customer_phone"] = sqlite3_column_text(stmt, 3) ? (const char*)sqlite3_column_text(stmt, 3) : "";
-                order["total_amount"] = sqlite3_column_double(stmt, 4);
-                order["status"] = (const char*)sqlite3_column_text(stmt, 5);
-                order["created_at"] = (const char*)sqlite3_column_text(stmt, 6);
-                order["item_count"] = sqlite3_column_int(stmt, 7);
-                orders.push_back(order);
+        auto stmt = conn.prepare(page->after ? queries::orders_after : queries::orders);
+        if (!stmt) {
+            res.status = 500;
+            res.set_content("{\"error\": \"Database error\"}", "application/json");
+            return;
+        }
+        sqlite3_bind_int64(stmt, 1, limit_with_lookahead(*page));
+        if (page->after) {
+            sqlite3_bind_int64(stmt, 2, *after_ms);
+            sqlite3_bind_int64(stmt, 3, page->after->id);
+        }
+        sqlite3_bind_int64(stmt, 4, range->from);
+        sqlite3_bind_int64(stmt, 5, range->last(*after_ms));
+
+        if (page->limit < 0) {
+            dbr::db::stream_json_array(res, std::move(stmt), [](sqlite3_stmt* row, std::string& out) {
+                OrderMapper::write_json(row, out);
+            });
+            return;
+        }
+
+        std::string body = "[";
+        std::int64_t last_ms = 0;
+        std::int64_t last_id = 0;
+        std::int64_t rows = 0;
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            if (rows++ == page->limit) {
+                set_next_cursor(res, encode_cursor(std::to_string(last_ms), last_id));
+                break;
             }
+            if (rows > 1) body += ',';
+            OrderMapper::write_json(stmt.get(), body);
+            last_id = sqlite3_column_int64(stmt, 0);
+            last_ms = sqlite3_column_int64(stmt, 7);
         }
-        sqlite3_finalize(stmt);
-        res.set_content(orders.dump(), "application/json");
+        body += ']';
+        res.set_content(std::move(body), "application/json");
+    });
+
+    // A customer's lifetime totals and order history, newest first, found by
+    // email (matched case-insensitively). Paginated with ?limit=&after=.
+    srv.Get("/api/customers/([^/]+)/orders", [db](const Request& req, Response& res) {
+        auto page = parse_page_request(req, res);
+        if (!page) return;
+        auto after_ms = order_cursor_ms(*page, res);
+        if (!after_ms || not_modified(req, res, *db, {"customers", "orders"})) return;
+        auto& conn = db->reader();
+        auto customer = conn.prepare(queries::customer_by_email);
+        auto orders = conn.prepare(page->after ? queries::customer_orders_after : queries::customer_orders);
+        if (!customer || !orders) {
+            res.status = 500;
+            res.set_content("{\"error\": \"Database error\"}", "application/json");
+            return;
+        }
+        auto key = customer_key(req.matches[1].str());
+        sqlite3_bind_text(customer, 1, key.c_str(), -1, SQLITE_TRANSIENT);
+        if (sqlite3_step(customer) != SQLITE_ROW) {
+            res.status = 404;
+            res.set_content("{\"error\": \"Customer not found\"}", "application/json");
+            return;
+        }
+
+        std::string body = "{\"customer\":";
+        CustomerMapper::write_json(customer.get(), body);
+        body += ",\"orders\":[";
+        sqlite3_bind_int64(orders, 1, sqlite3_column_int64(customer, 0));
+        sqlite3_bind_int64(orders, 2, limit_with_lookahead(*page));
+        if (page->after) {
+            sqlite3_bind_int64(orders, 3, *after_ms);
+            sqlite3_bind_int64(orders, 4, page->after->id);
+        }
+        std::int64_t last_ms = 0;
+        std::int64_t last_id = 0;
+        std::int64_t rows = 0;
+        while (sqlite3_step(orders) == SQLITE_ROW) {
+            if (rows++ == page->limit) {
+                set_next_cursor(res, encode_cursor(std::to_string(last_ms), last_id));
+                break;
+            }
+            if (rows > 1) body += ',';
+            OrderMapper::write_json(orders.get(), body);
+            last_id = sqlite3_column_int64(orders, 0);
+            last_ms = sqlite3_column_int64(orders, 7);
+        }
+        body += "]}";
+        res.set_content(std::move(body), "application/json");
+    });
+
+    // Sales analytics from the rollup tables: revenue for the last ?days=
+    // (default 30) days with sales, orders per status, and the ?top= (default
+    // 5) species and categories by units sold
+    srv.Get("/api/analytics", [db](const Request& req, Response& res) {
+        auto days = int_param(req, "days", 30, 1, 3660);
+        auto top = int_param(req, "top", 5, 1, 100);
+        if (!days || !top) {
+            res.status = 400;
+            res.set_content("{\"error\": \"days must be 1-3660 and top 1-100\"}", "application/json");
+            return;
+        }
+        if (not_modified(req, res, *db, {"sales_by_day", "sales_by_status", "sales_by_species",
+                                         "sales_by_category", "categories"})) {
+            return;
+        }
+        auto& conn = db->reader();
+        auto by_day = conn.prepare(queries::sales_by_day);
+        auto species = conn.prepare(queries::top_species);
+        auto categories = conn.prepare(queries::top_categories);
+        if (by_day) sqlite3_bind_int64(by_day, 1, *days);
+        if (species) sqlite3_bind_int64(species, 1, *top);
+        if (categories) sqlite3_bind_int64(categories, 1, *top);
+
+        std::string body = "{\"revenue_by_day\":";
+        bool ok = append_rows<DailySalesMapper>(body, std::move(by_day));
+        body += ",\"orders_by_status\":";
+        ok = ok && append_rows<StatusSalesMapper>(body, conn.prepare(queries::sales_by_status));
+        body += ",\"top_species\":";
+        ok = ok && append_rows<SpeciesSalesMapper>(body, std::move(species));
+        body += ",\"top_categories\":";
+        ok = ok && append_rows<CategorySalesMapper>(body, std::move(categories));
+        body += '}';
+        if (!ok) {
+            res.status = 500;
+            res.set_content("{\"error\": \"Database error\"}", "application/json");
+            return;
+        }
+        res.set_content(std::move(body), "application/json");
+    });
+
+    // Every order with its items as NDJSON, streamed from a single scan;
+    // gzip-compressed when the client accepts it
+    srv.Get("/api/orders/export", [db](const Request& req, Response& res) {
+        auto stmt = db->reader().prepare(queries::orders_export);
+        if (!stmt) {
+            res.status = 500;
+            res.set_content("{\"error\": \"Database error\"}", "application/json");
+            return;
+        }
+        res.set_header("Content-Disposition", "attachment; filename=\"orders.ndjson\"");
+        stream_order_export(res, std::move(stmt), dbr::accepts_gzip(req.get_header_value("Accept-Encoding")));
+    });
+
+    // Database statistics (statement and catalog cache hit rates, backup and
+    // maintenance runs)
+    srv.Get("/api/db/stats", [db, catalog, backup = backup_, maintenance = maintenance_](const Request& req, Response& res) {
+        auto stmts = db->statement_stats();
+        auto cached = catalog->stats();
+        json stats;
+        stats["statements"]["hits"] = stmts.hits;
+        stats["statements"]["misses"] = stmts.misses;
+        stats["statements"]["cached"] = stmts.cached;
+        stats["statements"]["hit_rate"] = stmts.hit_rate();
+        stats["catalog"]["hits"] = cached.hits;
+        stats["catalog"]["loads"] = cached.loads;
+        stats["catalog"]["invalidations"] = cached.invalidations;
+        if (auto replica = catalog->replica_stats()) {
+            stats["catalog"]["memory"]["bytes"] = replica->bytes;
+            stats["catalog"]["memory"]["loads"] = replica->loads;
+            stats["catalog"]["memory"]["load_seconds"] = replica->load_seconds;
+        }
+        stats["backup"] = backup_progress_json(backup->progress());
+        stats["maintenance"] = maintenance_json(maintenance->stats());
+        res.set_content(stats.dump(), "application/json");
     });
 
 
     return dbr::ErrorCode::Success;
 }
+
+
+// Every request postpones background maintenance until traffic quiets down
+void OwnServer::on_request_activity(const httplib::Request&) {
+    if (maintenance_) {
+        maintenance_->note_activity();
+    }
+}
+
+void OwnServer::setup_ipc_handlers(dbr::ipc::IPCHandlerRegistry& registry) {
+    using dbr::ipc::IPCMessage;
+    using dbr::ipc::IPCResponse;
+    auto backup = backup_;
+    if (!backup) {
+        return;
+    }
+
+    // Starts an online backup (params: optional "path"); progress is polled
+    // with db.backup.status
+    registry.register_handler("db.backup", [backup](const IPCMessage& msg) -> IPCResponse {
+        std::string path = msg.params.is_object() ? msg.params.value("path", "") : "";
+        json result;
+        result["started"] = backup->request(path);
+        result["progress"] = backup_progress_json(backup->progress());
+        return IPCResponse(result, msg.id);
+    });
+
+    registry.register_handler("db.backup.status", [backup](const IPCMessage& msg) -> IPCResponse {
+        return IPCResponse(backup_progress_json(backup->progress()), msg.id);
+    });
+}
@@ -1,12 +1,39 @@
 #pragma once
 
 #include "engine/http_server.hpp"
+#include "engine/db_pool.hpp"
+#include "engine/db_backup.hpp"
+#include "engine/db_maintenance.hpp"
+#include "order_writer.hpp"
+#include "catalog_cache.hpp"
 #include "common_defs.hpp"
 
+#include <memory>
+
+
+struct OwnServerOptions {
+    // Serve catalog queries from an in-memory copy of the catalog tables
+    // (see dbr::db::MemoryReplica). Reads skip the file entirely, but every
+    // write to a catalog table rebuilds the whole copy, so it only pays off
+    // for a catalog that is read far more often than it changes.
+    // Command line: --catalog-in-memory
+    bool catalog_in_memory = false;
+};
 
 class OwnServer : public dbr::Server {
 public:
+    explicit OwnServer(OwnServerOptions options = {}) : options_(options) {}
     virtual ~OwnServer() {}
+    virtual void setup_ipc_handlers(dbr::ipc::IPCHandlerRegistry& registry) override;
 protected:
     virtual dbr::ErrorCode own_configure(httplib::Server& srv) override;
+    virtual void on_request_activity(const httplib::Request& req) override;
+
+    std::shared_ptr<dbr::db::ConnectionPool> db_;
+    std::shared_ptr<OrderWriter> order_writer_;
+    std::shared_ptr<CatalogCache> catalog_;
+    std::shared_ptr<dbr::db::BackupRunner> backup_;
+    std::shared_ptr<dbr::db::MaintenanceScheduler> maintenance_;
+
+    OwnServerOptions options_;
 };
\ No newline at end of file
@@ -0,0 +1,422 @@
+#include "pet_import.hpp"
+#include "queries.hpp"
+#include "engine/arena.hpp"
+
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+#include <sqlite3.h>
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <string>
+#include <utility>
+
+namespace {
+
+enum Column { Name, Species, Breed, Age, Price, Description, ImageUrl, Available, Categories, ColumnCount };
+
+constexpr std::array<std::string_view, ColumnCount> column_names{
+    "name", "species", "breed", "age", "price", "description", "image_url", "available", "categories",
+};
+
+constexpr std::size_t max_reported_errors = 20;
+constexpr std::size_t max_record_bytes = 4 * 1024 * 1024;
+constexpr std::string_view utf8_bom = "\xEF\xBB\xBF";
+
+bool exec(sqlite3* db, const char* sql) {
+    char* err = nullptr;
+    if (sqlite3_exec(db, sql, nullptr, nullptr, &err) != SQLITE_OK) {
+        spdlog::error("{} failed: {}", sql, err ? err : "unknown error");
+        sqlite3_free(err);
+        return false;
+    }
+    return true;
+}
+
+std::string_view trim(std::string_view s) {
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t')) s.remove_suffix(1);
+    return s;
+}
+
+void split_categories(ImportedPet& pet, std::string_view list, char separator) {
+    while (!list.empty()) {
+        auto end = list.find(separator);
+        auto name = trim(list.substr(0, end));
+        if (!name.empty()) pet.categories.emplace_back(name);
+        list = end == std::string_view::npos ? std::string_view() : list.substr(end + 1);
+    }
+}
+
+// Sets one field from its text form; returns an error message or nullptr
+const char* set_field(ImportedPet& pet, int column, std::string_view value) {
+    value = trim(value);
+    switch (column) {
+        case Name: pet.name = value; break;
+        case Species: pet.species = value; break;
+        case Breed: pet.breed = value; break;
+        case Description: pet.description = value; break;
+        case ImageUrl: pet.image_url = value; break;
+        case Categories: split_categories(pet, value, ';'); break;
+        case Age: {
+            if (value.empty()) break;
+            auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), pet.age);
+            if (ec != std::errc() || end != value.data() + value.size()) return "age is not an integer";
+            break;
+        }
+        case Price: {
+            auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), pet.price);
+            if (value.empty() || ec != std::errc() || end != value.data() + value.size()) return "price is not a number";
+            break;
+        }
+        case Available:
+            if (value == "0" || value == "false" || value == "no") pet.available = false;
+            else if (value.empty() || value == "1" || value == "true" || value == "yes") pet.available = true;
+            else return "available is not a boolean";
+            break;
+    }
+    return nullptr;
+}
+
+const char* validate(const ImportedPet& pet) {
+    if (pet.name.empty()) return "name is required";
+    if (pet.species.empty()) return "species is required";
+    // from_chars and JSON both let NaN and infinities through
+    if (!std::isfinite(pet.price)) return "price must be a finite number";
+    if (pet.price < 0) return "price must not be negative";
+    return nullptr;
+}
+
+} // namespace
+
+PetImporter::PetImporter(std::shared_ptr<dbr::db::ConnectionPool> db, Format format, std::size_t batch_size)
+    : db_(std::move(db)), format_(format), batch_size_(batch_size),
+      started_(std::chrono::steady_clock::now()) {
+    batch_.reserve(batch_size_);
+}
+
+bool PetImporter::feed(std::string_view data) {
+    if (!stats_.fatal.empty()) {
+        return false;
+    }
+    // A leading UTF-8 byte order mark (as in Excel's CSV exports) is not
+    // data. It may arrive split across chunks.
+    if (bom_matched_ < utf8_bom.size()) {
+        while (!data.empty() && bom_matched_ < utf8_bom.size() && data[0] == utf8_bom[bom_matched_]) {
+            data.remove_prefix(1);
+            ++bom_matched_;
+        }
+        if (data.empty()) {
+            return true;
+        }
+        // Not a BOM after all: parse the bytes held back before the rest
+        auto held = bom_matched_ < utf8_bom.size() ? utf8_bom.substr(0, bom_matched_) : std::string_view{};
+        bom_matched_ = utf8_bom.size();
+        feed_text(held);
+    }
+    feed_text(data);
+    return stats_.fatal.empty();
+}
+
+void PetImporter::feed_text(std::string_view data) {
+    if (!stats_.fatal.empty()) {
+        return;
+    }
+    if (format_ == Format::Ndjson) {
+        feed_ndjson(data);
+    } else {
+        feed_csv(data);
+    }
+}
+
+ImportStats PetImporter::finish() {
+    if (stats_.fatal.empty()) {
+        if (format_ == Format::Ndjson) {
+            if (!line_.empty()) {
+                parse_json_record(line_);
+                line_.clear();
+            }
+        } else if (in_quotes_ && !quote_pending_) {
+            reject("unterminated quoted field at end of input");
+        } else if (!field_.empty() || !fields_.empty()) {
+            end_csv_record();
+        }
+    }
+    if (stats_.fatal.empty() && !batch_.empty()) {
+        commit_batch();
+    }
+    stats_.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started_).count();
+    return std::move(stats_);
+}
+
+void PetImporter::feed_ndjson(std::string_view data) {
+    while (!data.empty() && stats_.fatal.empty()) {
+        auto newline = data.find('\n');
+        if (line_.size() + std::min(newline, data.size()) > max_record_bytes) {
+            abort("record longer than " + std::to_string(max_record_bytes) + " bytes", true);
+            return;
+        }
+        if (newline == std::string_view::npos) {
+            line_.append(data);
+            return;
+        }
+        if (line_.empty()) {
+            parse_json_record(data.substr(0, newline));
+        } else {
+            line_.append(data.substr(0, newline));
+            parse_json_record(line_);
+            line_.clear();
+        }
+        data.remove_prefix(newline + 1);
+    }
+}
+
+void PetImporter::parse_json_record(std::string_view line) {
+    line = trim(line);
+    if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+    if (line.empty()) {
+        return;
+    }
+    dbr::arena::Scope scope;
+    auto record = dbr::arena::json::parse(line, nullptr, false);
+    if (!record.is_object()) {
+        reject("not a JSON object");
+        return;
+    }
+    ImportedPet pet;
+    for (int column = 0; column < ColumnCount; ++column) {
+        auto it = record.find(column_names[column]);
+        if (it == record.end() || it->is_null()) {
+            continue;
+        }
+        const char* error = nullptr;
+        if (it->is_string()) {
+            auto& text = it->get_ref<const dbr::arena::json::string_t&>();
+            if (column == Categories) {
+                split_categories(pet, text, ',');
+            } else {
+                error = set_field(pet, column, text);
+            }
+        } else if (column == Categories && it->is_array()) {
+            for (auto& name : *it) {
+                if (name.is_string()) pet.categories.emplace_back(std::string_view(name.get_ref<const dbr::arena::json::string_t&>()));
+            }
+        } else if (column == Age && it->is_number_integer()) {
+            pet.age = it->get<std::int64_t>();
+        } else if (column == Price && it->is_number()) {
+            pet.price = it->get<double>();
+        } else if (column == Available && (it->is_boolean() || it->is_number())) {
+            pet.available = it->is_boolean() ? it->get<bool>() : it->get<double>() != 0;
+        } else {
+            error = "unexpected value type";
+        }
+        if (error) {
+            reject(std::string(column_names[column]) + ": " + error);
+            return;
+        }
+    }
+    add(std::move(pet));
+}
+
+// RFC 4180 fields: quoted fields may hold separators, newlines and doubled
+// quotes. State survives chunk boundaries.
+void PetImporter::feed_csv(std::string_view data) {
+    for (char c : data) {
+        if (++record_bytes_ > max_record_bytes) {
+            abort("record longer than " + std::to_string(max_record_bytes) + " bytes", true);
+            return;
+        }
+        if (in_quotes_) {
+            if (quote_pending_) {
+                quote_pending_ = false;
+                if (c == '"') {
+                    field_ += '"';
+                    continue;
+                }
+                in_quotes_ = false;     // closing quote; c is read unquoted
+            } else if (c == '"') {
+                quote_pending_ = true;
+                continue;
+            } else {
+                field_ += c;
+                continue;
+            }
+        }
+        switch (c) {
+            case '"':
+                if (field_.empty()) in_quotes_ = true;
+                else field_ += c;
+                break;
+            case ',':
+                fields_.push_back(std::move(field_));
+                field_.clear();
+                break;
+            case '\r':
+                break;
+            case '\n':
+                end_csv_record();
+                if (!stats_.fatal.empty()) return;
+                break;
+            default:
+                field_ += c;
+        }
+    }
+}
+
+void PetImporter::end_csv_record() {
+    fields_.push_back(std::move(field_));
+    field_.clear();
+    record_bytes_ = 0;
+    if (fields_.size() == 1 && fields_[0].empty()) {
+        fields_.clear();    // blank line
+        return;
+    }
+    if (!have_header_) {
+        read_csv_header();
+    } else {
+        ImportedPet pet;
+        const char* error = nullptr;
+        int failed_column = -1;
+        for (std::size_t i = 0; i < fields_.size() && i < columns_.size() && !error; ++i) {
+            if (columns_[i] >= 0) {
+                error = set_field(pet, columns_[i], fields_[i]);
+                failed_column = columns_[i];
+            }
+        }
+        if (error) {
+            reject(std::string(column_names[failed_column]) + ": " + error);
+        } else {
+            add(std::move(pet));
+        }
+    }
+    fields_.clear();
+}
+
+void PetImporter::read_csv_header() {
+    have_header_ = true;
+    std::array<bool, ColumnCount> seen{};
+    for (auto& name : fields_) {
+        int column = -1;
+        for (int c = 0; c < ColumnCount; ++c) {
+            if (trim(name) == column_names[c]) column = c;
+        }
+        columns_.push_back(column);
+        if (column >= 0) seen[column] = true;
+    }
+    for (int required : {Name, Species, Price}) {
+        if (!seen[required]) {
+            abort("CSV header has no '" + std::string(column_names[required]) + "' column", true);
+            return;
+        }
+    }
+}
+
+void PetImporter::reject(std::string error) {
+    ++stats_.records;
+    ++stats_.rejected;
+    if (stats_.errors.size() < max_reported_errors) {
+        stats_.errors.push_back("record " + std::to_string(stats_.records) + ": " + error);
+    }
+}
+
+void PetImporter::abort(std::string error, bool bad_input) {
+    stats_.fatal = std::move(error);
+    stats_.bad_input = bad_input;
+}
+
+void PetImporter::add(ImportedPet pet) {
+    if (auto error = validate(pet)) {
+        reject(error);
+        return;
+    }
+    ++stats_.records;
+    batch_.push_back(std::move(pet));
+    if (batch_.size() >= batch_size_) {
+        commit_batch();
+    }
+}
+
+std::int64_t PetImporter::category_id(dbr::db::ConnectionPool::WriteLease& conn, const std::string& name) {
+    if (auto it = categories_.find(name); it != categories_.end()) {
+        return it->second;
+    }
+    auto stmt = conn.prepare(queries::insert_category);
+    if (!stmt) return 0;
+    sqlite3_bind_text(stmt, 1, name.c_str(), -1, SQLITE_STATIC);
+    if (sqlite3_step(stmt) != SQLITE_ROW) {
+        return 0;
+    }
+    std::int64_t id = sqlite3_column_int64(stmt, 0);
+    categories_.emplace(name, id);
+    return id;
+}
+
+bool PetImporter::commit_batch() {
+    bool ok = false;
+    {
+        auto conn = db_->writer();
+        if (exec(conn, "BEGIN IMMEDIATE")) {
+            if (!categories_loaded_) {
+                if (auto stmt = conn.prepare(queries::category_ids)) {
+                    while (sqlite3_step(stmt) == SQLITE_ROW) {
+                        categories_.emplace(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1)),
+                                            sqlite3_column_int64(stmt, 0));
+                    }
+                    categories_loaded_ = true;
+                }
+            }
+            auto insert = conn.prepare(queries::insert_pet);
+            auto link = conn.prepare(queries::insert_pet_category);
+            ok = insert && link && categories_loaded_;
+            for (auto& pet : batch_) {
+                if (!ok) break;
+                sqlite3_bind_text(insert, 1, pet.name.c_str(), -1, SQLITE_STATIC);
+                sqlite3_bind_text(insert, 2, pet.species.c_str(), -1, SQLITE_STATIC);
+                sqlite3_bind_text(insert, 3, pet.breed.c_str(), -1, SQLITE_STATIC);
+                sqlite3_bind_int64(insert, 4, pet.age);
+                sqlite3_bind_double(insert, 5, pet.price);
+                sqlite3_bind_text(insert, 6, pet.description.c_str(), -1, SQLITE_STATIC);
+                sqlite3_bind_text(insert, 7, pet.image_url.c_str(), -1, SQLITE_STATIC);
+                sqlite3_bind_int(insert, 8, pet.available ? 1 : 0);
+                ok = sqlite3_step(insert) == SQLITE_DONE;
+                sqlite3_reset(insert);
+                std::int64_t pet_id = sqlite3_last_insert_rowid(conn);
+                for (auto& name : pet.categories) {
+                    std::int64_t category = ok ? category_id(conn, name) : 0;
+                    if (!category) {
+                        ok = false;
+                        break;
+                    }
+                    sqlite3_bind_int64(link, 1, pet_id);
+                    sqlite3_bind_int64(link, 2, category);
+                    ok = sqlite3_step(link) == SQLITE_DONE;
+                    sqlite3_reset(link);
+                }
+            }
+            if (!ok) {
+                spdlog::error("Pet import batch failed: {}", sqlite3_errmsg(conn));
+            }
+            ok = ok && exec(conn, "COMMIT");
+            if (!ok) {
+                exec(conn, "ROLLBACK");
+                // Ids of categories created in this batch are gone too
+                categories_.clear();
+                categories_loaded_ = false;
+            }
+        }
+    }
+
+    if (!ok) {
+        abort("database error while importing", false);
+        return false;
+    }
+    stats_.imported += static_cast<std::int64_t>(batch_.size());
+    ++stats_.batches;
+    batch_.clear();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started_).count();
+    spdlog::info("Pet import: {} imported, {} rejected ({:.0f} records/s)", stats_.imported,
+                 stats_.rejected, seconds > 0 ? stats_.records / seconds : 0.0);
+    return true;
+}
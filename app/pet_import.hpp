@@ -0,0 +1,97 @@
+#pragma once
+
+#include "engine/db_pool.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+struct ImportedPet {
+    std::string name;
+    std::string species;
+    std::string breed;
+    std::int64_t age = 0;
+    double price = 0.0;
+    std::string description;
+    std::string image_url;
+    bool available = true;
+    std::vector<std::string> categories;
+};
+
+struct ImportStats {
+    std::int64_t records = 0;       // records parsed, good or bad
+    std::int64_t imported = 0;
+    std::int64_t rejected = 0;      // malformed records, skipped
+    std::int64_t batches = 0;
+    double seconds = 0.0;
+    std::vector<std::string> errors;    // the first few rejections
+    std::string fatal;              // set if the import was aborted
+    bool bad_input = false;         // ... because of the input (else the database)
+};
+
+// Streaming bulk import of pets (POST /api/pets/import).
+//
+// The request body is fed in as it arrives. NDJSON records are one JSON
+// object per line; CSV has a header row naming the columns (name, species,
+// price required; breed, age, description, image_url, available,
+// categories optional, categories separated by ';'). Field names are the
+// pets columns plus "categories" (an array of names in NDJSON).
+//
+// Complete records are queued and written `batch_size` at a time, each
+// batch in one IMMEDIATE transaction with the writer's cached insert
+// statements. Category names resolve through a name-to-id map loaded once;
+// unknown names create the category. Memory is bounded by one batch plus
+// one partial record, whatever the size of the body: a record longer than
+// 4 MB aborts the import as bad input. A leading UTF-8 BOM is skipped.
+class PetImporter {
+public:
+    enum class Format { Ndjson, Csv };
+
+    PetImporter(std::shared_ptr<dbr::db::ConnectionPool> db, Format format,
+                std::size_t batch_size = 5000);
+
+    // Consumes the next piece of the body. Returns false once the import
+    // has been aborted (see ImportStats::fatal); further input is ignored.
+    bool feed(std::string_view data);
+
+    // Parses the trailing record, writes the last batch and returns totals
+    ImportStats finish();
+
+private:
+    void feed_text(std::string_view data);
+    void feed_ndjson(std::string_view data);
+    void feed_csv(std::string_view data);
+    void parse_json_record(std::string_view line);
+    void end_csv_record();
+    void read_csv_header();
+    void add(ImportedPet pet);
+    void reject(std::string error);
+    void abort(std::string error, bool bad_input);
+    bool commit_batch();
+    std::int64_t category_id(dbr::db::ConnectionPool::WriteLease& conn, const std::string& name);
+
+    std::shared_ptr<dbr::db::ConnectionPool> db_;
+    const Format format_;
+    const std::size_t batch_size_;
+    std::chrono::steady_clock::time_point started_;
+    ImportStats stats_;
+    std::vector<ImportedPet> batch_;
+
+    std::unordered_map<std::string, std::int64_t> categories_;
+    bool categories_loaded_ = false;
+
+    // Parser state carried across chunks
+    std::size_t bom_matched_ = 0;       // leading bytes matched against a UTF-8 BOM
+    std::size_t record_bytes_ = 0;      // CSV bytes read of the current record
+    std::string line_;
+    std::vector<std::string> fields_;
+    std::string field_;
+    bool in_quotes_ = false;
+    bool quote_pending_ = false;
+    std::vector<int> columns_;          // ImportedPet field per CSV column, -1 = ignored
+    bool have_header_ = false;
+};
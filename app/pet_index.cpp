@@ -0,0 +1,53 @@
+#include "pet_index.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+
+void PetIndex::add(std::int64_t id, double price, std::optional<std::int64_t> age,
+                   std::string_view species, bool available) {
+    ids_.push_back(id);
+    price_.push_back(price);
+    age_.push_back(age ? static_cast<std::int32_t>(std::clamp<std::int64_t>(*age, 0, INT32_MAX)) : no_age);
+    auto [it, added] = species_ids_.try_emplace(std::string(species),
+                                                static_cast<std::uint32_t>(species_ids_.size()));
+    species_.push_back(it->second);
+    flags_.push_back(available ? available_flag : 0);
+}
+
+void PetIndex::finish() {
+    auto rows = dbr::columns::padded(ids_.size());
+    price_.resize(rows);
+    age_.resize(rows, no_age);
+    species_.resize(rows, UINT32_MAX);
+    flags_.resize(rows);
+
+    by_price_.resize(ids_.size());
+    std::iota(by_price_.begin(), by_price_.end(), 0u);
+    std::sort(by_price_.begin(), by_price_.end(), [&](std::uint32_t a, std::uint32_t b) {
+        return price_[a] != price_[b] ? price_[a] < price_[b] : ids_[a] < ids_[b];
+    });
+}
+
+dbr::columns::Bitmap PetIndex::match(const PetFilter& filter) const {
+    using namespace dbr::columns;
+    Bitmap bits = all_rows(size(), capacity());
+    if (filter.species) {
+        auto it = species_ids_.find(*filter.species);
+        if (it == species_ids_.end()) {
+            return Bitmap(bits.size(), 0);
+        }
+        keep_equal(species_.data(), it->second, bits);
+    }
+    if (filter.available) {
+        keep_masked(flags_.data(), available_flag, *filter.available ? available_flag : 0, bits);
+    }
+    if (filter.min_price || filter.max_price) {
+        keep_between(price_.data(), filter.min_price.value_or(-std::numeric_limits<double>::infinity()),
+                     filter.max_price.value_or(std::numeric_limits<double>::infinity()), bits);
+    }
+    if (filter.min_age || filter.max_age) {
+        keep_between(age_.data(), filter.min_age.value_or(0), filter.max_age.value_or(INT32_MAX), bits);
+    }
+    return bits;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "engine/column_filter.hpp"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+enum class PetSort { Newest, PriceAsc, PriceDesc };
+
+// Filters and order of a /api/pets listing
+struct PetFilter {
+    std::optional<std::string> category;
+    std::optional<std::string> species;
+    std::optional<bool> available = true;   // nullopt: either
+    std::optional<double> min_price;
+    std::optional<double> max_price;
+    std::optional<std::int32_t> min_age;
+    std::optional<std::int32_t> max_age;
+    PetSort sort = PetSort::Newest;
+
+    // No filter but availability, newest first
+    bool plain() const {
+        return !category && !species && available == true && !min_price && !max_price
+            && !min_age && !max_age && sort == PetSort::Newest;
+    }
+};
+
+// Columnar copy of the pet attributes /api/pets filters and sorts on.
+//
+// One row per pet, in the order they were added (the snapshot's listing
+// order), stored struct-of-arrays so each predicate is a SIMD pass over one
+// dense column (see dbr::columns). Columns are padded to a multiple of 64
+// rows. Built once per catalog snapshot and immutable afterwards.
+class PetIndex {
+public:
+    static constexpr std::uint8_t available_flag = 1;
+
+    void add(std::int64_t id, double price, std::optional<std::int64_t> age,
+             std::string_view species, bool available);
+
+    // Pads the columns and builds the price order; call after the last add()
+    void finish();
+
+    std::size_t size() const { return ids_.size(); }
+    std::size_t capacity() const { return price_.size(); }
+
+    // Rows passing the filter's species, availability, price and age
+    // predicates (the category is up to the caller)
+    dbr::columns::Bitmap match(const PetFilter& filter) const;
+
+    std::int64_t id(std::uint32_t row) const { return ids_[row]; }
+    double price(std::uint32_t row) const { return price_[row]; }
+
+    // Rows by (price, id) ascending
+    const std::vector<std::uint32_t>& by_price() const { return by_price_; }
+
+private:
+    // Stands for a NULL age: below every range a request can ask for
+    static constexpr std::int32_t no_age = INT32_MIN;
+
+    std::vector<std::int64_t> ids_;
+    std::vector<double> price_;
+    std::vector<std::int32_t> age_;
+    std::vector<std::uint32_t> species_;
+    std::vector<std::uint8_t> flags_;
+    std::unordered_map<std::string, std::uint32_t> species_ids_;
+    std::vector<std::uint32_t> by_price_;
+};
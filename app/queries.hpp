@@ -0,0 +1,292 @@
+#pragma once
+
+#include <array>
+#include <string>
+#include <vector>
+
+// SQL text of every API query, declared once. Each distinct string is
+// compiled once per connection by the statement cache and reused from then
+// on, so queries must not be assembled per request.
+namespace queries {
+
+inline constexpr const char* pet_by_id = R"(
+    SELECT p.*,
+        (SELECT GROUP_CONCAT(c.name) FROM pet_categories pc
+            JOIN categories c ON c.id = pc.category_id
+            WHERE pc.pet_id = p.id) AS categories
+    FROM pets p
+    WHERE p.id = ?
+)";
+
+inline constexpr const char* categories = "SELECT id, name, description FROM categories ORDER BY name";
+
+// Whole catalog for the in-memory cache (catalog_cache.hpp): every pet in
+// listing order with the same columns as the API queries, and the
+// pet-to-category links.
+inline constexpr const char* catalog_pets = R"(
+    SELECT p.*,
+        (SELECT GROUP_CONCAT(c.name) FROM pet_categories pc
+            JOIN categories c ON c.id = pc.category_id
+            WHERE pc.pet_id = p.id) AS categories
+    FROM pets p
+    ORDER BY p.created_at DESC, p.id DESC
+)";
+
+inline constexpr const char* catalog_pet_categories = R"(
+    SELECT pc.pet_id, c.name FROM pet_categories pc
+    JOIN categories c ON c.id = pc.category_id
+)";
+
+// Ids of the pets matching an FTS5 expression (/api/facets)
+inline constexpr const char* search_pet_ids = "SELECT rowid FROM pets_fts WHERE pets_fts MATCH ?1";
+
+// Bulk import (pet_import.hpp)
+inline constexpr const char* insert_pet = R"(
+    INSERT INTO pets (name, species, breed, age, price, description, image_url, available)
+    VALUES (?, ?, ?, ?, ?, ?, ?, ?)
+)";
+
+inline constexpr const char* insert_pet_category =
+    "INSERT OR IGNORE INTO pet_categories (pet_id, category_id) VALUES (?, ?)";
+
+// Id of the named category, created if missing. The map of a running
+// import can be stale: another import may have created the name since.
+inline constexpr const char* insert_category = R"(
+    INSERT INTO categories (name) VALUES (?)
+    ON CONFLICT (name) DO UPDATE SET name = excluded.name
+    RETURNING id
+)";
+
+inline constexpr const char* category_ids = "SELECT id, name FROM categories";
+
+// ?5 = creation time in epoch milliseconds; created_at is derived from it
+inline constexpr const char* insert_order = R"(
+    INSERT INTO orders (customer_name, customer_email, customer_phone, total_amount, status,
+        created_ms, created_at)
+    VALUES (?1, ?2, ?3, ?4, 'pending', ?5, strftime('%Y-%m-%d %H:%M:%S', ?5 / 1000, 'unixepoch'))
+)";
+
+inline constexpr const char* insert_order_item =
+    "INSERT INTO order_items (order_id, pet_id, quantity, price) VALUES (?, ?, ?, ?)";
+
+// Orders, newest first, with created_ms BETWEEN ?4 AND ?5 (epoch
+// milliseconds; the caller binds the widest range when unfiltered).
+// ?1 = row limit (-1 for all); the paged variant continues after the
+// keyset cursor (?2 = created_ms, ?3 = id). The caller also caps ?5 at the
+// cursor's created_ms, so the index range starts at the cursor rather than
+// at the end of the date range. Item counts are stored on the order
+// (migrations::order_item_totals), so a page reads only its own rows from
+// idx_orders_created_ms, and a date range only the rows inside it.
+inline constexpr const char* orders = R"(
+    SELECT o.id, o.customer_name, o.customer_email, o.customer_phone, o.total_amount, o.status, o.created_at,
+        o.created_ms, o.item_count, o.item_subtotal
+    FROM orders o
+    WHERE o.created_ms BETWEEN ?4 AND ?5
+    ORDER BY o.created_ms DESC, o.id DESC
+    LIMIT ?1
+)";
+
+inline constexpr const char* orders_after = R"(
+    SELECT o.id, o.customer_name, o.customer_email, o.customer_phone, o.total_amount, o.status, o.created_at,
+        o.created_ms, o.item_count, o.item_subtotal
+    FROM orders o
+    WHERE o.created_ms BETWEEN ?4 AND ?5 AND (o.created_ms, o.id) < (?2, ?3)
+    ORDER BY o.created_ms DESC, o.id DESC
+    LIMIT ?1
+)";
+
+// /api/customers/{email}/orders. ?1 = normalized email (see
+// migrations::customers); the customer row carries the lifetime totals.
+inline constexpr const char* customer_by_email = R"(
+    SELECT id, email, order_count, total_spent, first_order_at, last_order_at
+    FROM customers
+    WHERE email = ?1
+)";
+
+// A customer's orders, newest first: a range of idx_orders_customer.
+// ?1 = customer id, ?2 = row limit; the paged variant continues after the
+// keyset cursor (?3 = created_ms, ?4 = id).
+inline constexpr const char* customer_orders = R"(
+    SELECT o.id, o.customer_name, o.customer_email, o.customer_phone, o.total_amount, o.status, o.created_at,
+        o.created_ms, o.item_count, o.item_subtotal
+    FROM orders o
+    WHERE o.customer_id = ?1
+    ORDER BY o.created_ms DESC, o.id DESC
+    LIMIT ?2
+)";
+
+inline constexpr const char* customer_orders_after = R"(
+    SELECT o.id, o.customer_name, o.customer_email, o.customer_phone, o.total_amount, o.status, o.created_at,
+        o.created_ms, o.item_count, o.item_subtotal
+    FROM orders o
+    WHERE o.customer_id = ?1 AND (o.created_ms, o.id) < (?3, ?4)
+    ORDER BY o.created_ms DESC, o.id DESC
+    LIMIT ?2
+)";
+
+// Orders newest first, each followed by its items and their pets, for
+// /api/orders?expand=items: order columns (OrderMapper) then item columns
+// (OrderItemDetailMapper, NULL for an order without items). There is no
+// LIMIT: the plan walks idx_orders_created_ms and fetches each order's
+// items from idx_order_items_order as it goes, so the caller stops stepping
+// once it has the orders it wants and a page costs one pass over its own
+// rows. ?3, ?4 = created_ms range as in `orders` (?4 capped at the cursor);
+// the paged variant continues after the keyset cursor (?1 = created_ms,
+// ?2 = id).
+inline constexpr const char* orders_with_items = R"(
+    SELECT o.id, o.customer_name, o.customer_email, o.customer_phone, o.total_amount, o.status, o.created_at,
+        o.created_ms, o.item_count, o.item_subtotal,
+        oi.id, oi.pet_id, p.name AS pet_name, oi.quantity, oi.price
+    FROM orders o
+    LEFT JOIN order_items oi ON oi.order_id = o.id
+    LEFT JOIN pets p ON p.id = oi.pet_id
+    WHERE o.created_ms BETWEEN ?3 AND ?4
+    ORDER BY o.created_ms DESC, o.id DESC, oi.id
+)";
+
+inline constexpr const char* orders_with_items_after = R"(
+    SELECT o.id, o.customer_name, o.customer_email, o.customer_phone, o.total_amount, o.status, o.created_at,
+        o.created_ms, o.item_count, o.item_subtotal,
+        oi.id, oi.pet_id, p.name AS pet_name, oi.quantity, oi.price
+    FROM orders o
+    LEFT JOIN order_items oi ON oi.order_id = o.id
+    LEFT JOIN pets p ON p.id = oi.pet_id
+    WHERE o.created_ms BETWEEN ?3 AND ?4 AND (o.created_ms, o.id) < (?1, ?2)
+    ORDER BY o.created_ms DESC, o.id DESC, oi.id
+)";
+
+// Every order with its items, for the NDJSON export: order columns
+// (OrderHeaderMapper) then item columns (OrderItemMapper, NULL for an order
+// without items). One pass over orders in id order; each order's items
+// come from idx_order_items_order already in id order, so nothing is sorted.
+inline constexpr const char* orders_export = R"(
+    SELECT o.id, o.customer_name, o.customer_email, o.customer_phone, o.total_amount, o.status, o.created_at,
+        oi.id, oi.pet_id, oi.quantity, oi.price
+    FROM orders o
+    LEFT JOIN order_items oi ON oi.order_id = o.id
+    ORDER BY o.id, oi.id
+)";
+
+// /api/analytics, read from the rollup tables (see migrations::sales_rollups).
+// ?1 = number of rows (days, or top entries).
+inline constexpr const char* sales_by_day =
+    "SELECT day, orders, revenue FROM sales_by_day ORDER BY day DESC LIMIT ?1";
+
+inline constexpr const char* sales_by_status =
+    "SELECT status, orders, revenue FROM sales_by_status WHERE orders > 0 ORDER BY orders DESC";
+
+inline constexpr const char* top_species = R"(
+    SELECT species, units, revenue FROM sales_by_species
+    WHERE units > 0 ORDER BY units DESC, revenue DESC LIMIT ?1
+)";
+
+inline constexpr const char* top_categories = R"(
+    SELECT c.id, c.name, s.units, s.revenue FROM sales_by_category s
+    JOIN categories c ON c.id = s.category_id
+    WHERE s.units > 0 ORDER BY s.units DESC, s.revenue DESC LIMIT ?1
+)";
+
+// The /api/pets filter combinations, each its own cached statement.
+// Parameters: ?1 = category name, ?2 = FTS5 match expression, ?3 = row
+// limit (-1 for all), ?4/?5 = keyset cursor (sort key, id) when paged,
+// ?6 = availability (searches only; NULL for either), ?7 = species,
+// ?8/?9 = price range, ?10/?11 = age range (each NULL when not filtered).
+// Plain listings are newest first and paged on (created_at, id), which
+// walks idx_pets_available_created. Searches are answered from the pets_fts
+// index, ordered by relevance (bm25, name weighted highest) and paged on
+// (score, id); the score is returned as a trailing column. Filtered
+// listings are normally served by the catalog cache's PetIndex instead.
+inline const std::string& pets(bool by_category, bool by_search, bool paged) {
+    static const std::array<std::string, 8> variants = [] {
+        std::array<std::string, 8> v;
+        for (int i = 0; i < 8; ++i) {
+            bool by_category = i & 1, by_search = i & 2, paged = i & 4;
+            std::string& q = v[i];
+            if (by_search) {
+                q = R"(
+    WITH hits AS MATERIALIZED (
+        SELECT rowid AS id, bm25(pets_fts, 10.0, 5.0, 5.0, 1.0) AS score
+        FROM pets_fts WHERE pets_fts MATCH ?2
+    )
+    SELECT p.*,
+        (SELECT GROUP_CONCAT(c.name) FROM pet_categories pc
+            JOIN categories c ON c.id = pc.category_id
+            WHERE pc.pet_id = p.id) AS categories,
+        h.score
+    FROM hits h
+    JOIN pets p ON p.id = h.id
+    WHERE p.available = coalesce(?6, p.available))";
+            } else {
+                q = R"(
+    SELECT p.*,
+        (SELECT GROUP_CONCAT(c.name) FROM pet_categories pc
+            JOIN categories c ON c.id = pc.category_id
+            WHERE pc.pet_id = p.id) AS categories
+    FROM pets p
+    WHERE p.available = 1)";
+            }
+            q += R"(
+    AND (?7 IS NULL OR p.species = ?7)
+    AND (?8 IS NULL OR p.price >= ?8) AND (?9 IS NULL OR p.price <= ?9)
+    AND (?10 IS NULL OR p.age >= ?10) AND (?11 IS NULL OR p.age <= ?11))";
+            if (by_category) {
+                q += R"(
+    AND p.id IN (SELECT pc.pet_id FROM categories c
+        JOIN pet_categories pc ON pc.category_id = c.id
+        WHERE c.name = ?1))";
+            }
+            if (paged) {
+                q += by_search ? " AND (h.score, p.id) > (?4, ?5)"
+                               : " AND (p.created_at, p.id) < (?4, ?5)";
+            }
+            q += by_search ? " ORDER BY h.score, p.id"
+                           : " ORDER BY p.created_at DESC, p.id DESC";
+            q += " LIMIT ?3";
+        }
+        return v;
+    }();
+    return variants[(by_category ? 1 : 0) | (by_search ? 2 : 0) | (paged ? 4 : 0)];
+}
+
+struct Checked {
+    std::string name;
+    std::string sql;
+    std::vector<std::string> allowed_scans;
+};
+
+// Every API query, for the query-plan regression check (see
+// dbr::db::full_scans). allowed_scans names plan steps that may legitimately
+// read a whole relation, e.g. the materialized FTS hit list.
+inline std::vector<Checked> all() {
+    std::vector<Checked> checked;
+    for (int i = 0; i < 8; ++i) {
+        bool by_category = i & 1, by_search = i & 2, paged = i & 4;
+        std::string name = "pets";
+        if (by_category) name += " category";
+        if (by_search) name += " search";
+        if (paged) name += " after";
+        checked.push_back({name, pets(by_category, by_search, paged), {}});
+        if (by_search) checked.back().allowed_scans = {"h"};
+    }
+    checked.push_back({"pet_by_id", pet_by_id, {}});
+    checked.push_back({"categories", categories, {}});
+    checked.push_back({"search pet ids", search_pet_ids, {}});
+    checked.push_back({"catalog pets", catalog_pets, {"p"}});
+    checked.push_back({"catalog pet categories", catalog_pet_categories, {"pc", "c"}});
+    // Rollups hold one row per bucket; reading them whole is the point
+    checked.push_back({"sales by day", sales_by_day, {}});
+    checked.push_back({"sales by status", sales_by_status, {"sales_by_status"}});
+    checked.push_back({"top species", top_species, {"sales_by_species"}});
+    checked.push_back({"top categories", top_categories, {"s"}});
+    checked.push_back({"orders", orders, {}});
+    checked.push_back({"orders after", orders_after, {}});
+    checked.push_back({"customer by email", customer_by_email, {}});
+    checked.push_back({"customer orders", customer_orders, {}});
+    checked.push_back({"customer orders after", customer_orders_after, {}});
+    checked.push_back({"orders with items", orders_with_items, {}});
+    checked.push_back({"orders with items after", orders_with_items_after, {}});
+    checked.push_back({"orders export", orders_export, {"o"}});
+    return checked;
+}
+
+} // namespace queries
@@ -0,0 +1,28 @@
+#include "migrations.hpp"
+#include "query_plans.hpp"
+
+#include <spdlog/spdlog.h>
+#include <sqlite3.h>
+
+// Applies every migration to an empty in-memory database and fails if any
+// API query falls back to a full scan. Registered with ctest, so a schema or
+// query change that loses an index fails the test run.
+int main() {
+    sqlite3* db = nullptr;
+    if (sqlite3_open(":memory:", &db) != SQLITE_OK) {
+        spdlog::error("Cannot open an in-memory database: {}", db ? sqlite3_errmsg(db) : "out of memory");
+        sqlite3_close(db);
+        return 1;
+    }
+    int status = 0;
+    if (!dbr::db::migrate(db, migrations::all)) {
+        status = 1;
+    } else if (auto scans = check_query_plans(db); scans > 0) {
+        spdlog::error("{} full scan(s) in API queries", scans);
+        status = 1;
+    } else {
+        spdlog::info("{} API queries checked, no full scans", queries::all().size());
+    }
+    sqlite3_close(db);
+    return status;
+}
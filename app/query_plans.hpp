@@ -0,0 +1,24 @@
+#pragma once
+
+#include "engine/db_connection.hpp"
+#include "queries.hpp"
+
+#include <spdlog/spdlog.h>
+#include <sqlite3.h>
+
+#include <cstddef>
+
+// Query-plan regression check: logs every API query (queries::all()) that
+// reads a whole table without an index and returns how many such scans it
+// found. `db` must hold the migrated schema. Run by the query_plan_check
+// test and, in debug builds, at startup.
+inline std::size_t check_query_plans(sqlite3* db) {
+    std::size_t scans = 0;
+    for (auto& query : queries::all()) {
+        for (auto& scan : dbr::db::full_scans(db, query.sql, query.allowed_scans)) {
+            spdlog::error("Query '{}' falls back to a full scan: {}", query.name, scan);
+            ++scans;
+        }
+    }
+    return scans;
+}
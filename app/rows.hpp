@@ -0,0 +1,179 @@
+#pragma once
+
+#include "engine/row_mapper.hpp"
+
+#include <cstdint>
+#include <string_view>
+
+// Result rows of the API queries (see queries.hpp), declared once. Field
+// order is SELECT column order; keys are both JSON keys and column names.
+
+struct PetRow {
+    std::int64_t id;
+    std::string_view name;
+    std::string_view species;
+    std::string_view breed;
+    std::int64_t age;
+    double price;
+    std::string_view description;
+    std::string_view image_url;
+    bool available;
+    std::string_view created_at;
+    std::string_view categories;
+};
+
+using PetMapper = dbr::db::RowMapper<PetRow,
+    dbr::db::Field<"id", &PetRow::id>,
+    dbr::db::Field<"name", &PetRow::name>,
+    dbr::db::Field<"species", &PetRow::species>,
+    dbr::db::Field<"breed", &PetRow::breed>,
+    dbr::db::Field<"age", &PetRow::age>,
+    dbr::db::Field<"price", &PetRow::price>,
+    dbr::db::Field<"description", &PetRow::description>,
+    dbr::db::Field<"image_url", &PetRow::image_url>,
+    dbr::db::Field<"available", &PetRow::available>,
+    dbr::db::Field<"created_at", &PetRow::created_at>,
+    dbr::db::Field<"categories", &PetRow::categories>>;
+
+struct CategoryRow {
+    std::int64_t id;
+    std::string_view name;
+    std::string_view description;
+};
+
+using CategoryMapper = dbr::db::RowMapper<CategoryRow,
+    dbr::db::Field<"id", &CategoryRow::id>,
+    dbr::db::Field<"name", &CategoryRow::name>,
+    dbr::db::Field<"description", &CategoryRow::description>>;
+
+struct OrderRow {
+    std::int64_t id;
+    std::string_view customer_name;
+    std::string_view customer_email;
+    std::string_view customer_phone;
+    double total_amount;
+    std::string_view status;
+    std::string_view created_at;
+    std::int64_t created_ms;
+    std::int64_t item_count;
+    double item_subtotal;
+};
+
+using OrderMapper = dbr::db::RowMapper<OrderRow,
+    dbr::db::Field<"id", &OrderRow::id>,
+    dbr::db::Field<"customer_name", &OrderRow::customer_name>,
+    dbr::db::Field<"customer_email", &OrderRow::customer_email>,
+    dbr::db::Field<"customer_phone", &OrderRow::customer_phone>,
+    dbr::db::Field<"total_amount", &OrderRow::total_amount>,
+    dbr::db::Field<"status", &OrderRow::status>,
+    dbr::db::Field<"created_at", &OrderRow::created_at>,
+    dbr::db::Field<"created_ms", &OrderRow::created_ms>,
+    dbr::db::Field<"item_count", &OrderRow::item_count>,
+    dbr::db::Field<"item_subtotal", &OrderRow::item_subtotal>>;
+
+// Order columns without the item aggregates, for queries that join the items
+// themselves (queries::orders_export)
+using OrderHeaderMapper = dbr::db::RowMapper<OrderRow,
+    dbr::db::Field<"id", &OrderRow::id>,
+    dbr::db::Field<"customer_name", &OrderRow::customer_name>,
+    dbr::db::Field<"customer_email", &OrderRow::customer_email>,
+    dbr::db::Field<"customer_phone", &OrderRow::customer_phone>,
+    dbr::db::Field<"total_amount", &OrderRow::total_amount>,
+    dbr::db::Field<"status", &OrderRow::status>,
+    dbr::db::Field<"created_at", &OrderRow::created_at>>;
+
+struct OrderItemRow {
+    std::int64_t id;
+    std::int64_t pet_id;
+    std::int64_t quantity;
+    double price;
+};
+
+using OrderItemMapper = dbr::db::RowMapper<OrderItemRow,
+    dbr::db::Field<"id", &OrderItemRow::id>,
+    dbr::db::Field<"pet_id", &OrderItemRow::pet_id>,
+    dbr::db::Field<"quantity", &OrderItemRow::quantity>,
+    dbr::db::Field<"price", &OrderItemRow::price>>;
+
+// An order item with the pet's name, for /api/orders?expand=items
+struct OrderItemDetailRow {
+    std::int64_t id;
+    std::int64_t pet_id;
+    std::string_view pet_name;
+    std::int64_t quantity;
+    double price;
+};
+
+using OrderItemDetailMapper = dbr::db::RowMapper<OrderItemDetailRow,
+    dbr::db::Field<"id", &OrderItemDetailRow::id>,
+    dbr::db::Field<"pet_id", &OrderItemDetailRow::pet_id>,
+    dbr::db::Field<"pet_name", &OrderItemDetailRow::pet_name>,
+    dbr::db::Field<"quantity", &OrderItemDetailRow::quantity>,
+    dbr::db::Field<"price", &OrderItemDetailRow::price>>;
+
+// /api/customers/{email}/orders
+
+struct CustomerRow {
+    std::int64_t id;
+    std::string_view email;
+    std::int64_t order_count;
+    double total_spent;
+    std::string_view first_order_at;
+    std::string_view last_order_at;
+};
+
+using CustomerMapper = dbr::db::RowMapper<CustomerRow,
+    dbr::db::Field<"id", &CustomerRow::id>,
+    dbr::db::Field<"email", &CustomerRow::email>,
+    dbr::db::Field<"order_count", &CustomerRow::order_count>,
+    dbr::db::Field<"total_spent", &CustomerRow::total_spent>,
+    dbr::db::Field<"first_order_at", &CustomerRow::first_order_at>,
+    dbr::db::Field<"last_order_at", &CustomerRow::last_order_at>>;
+
+// /api/analytics buckets
+
+struct DailySalesRow {
+    std::string_view day;
+    std::int64_t orders;
+    double revenue;
+};
+
+using DailySalesMapper = dbr::db::RowMapper<DailySalesRow,
+    dbr::db::Field<"day", &DailySalesRow::day>,
+    dbr::db::Field<"orders", &DailySalesRow::orders>,
+    dbr::db::Field<"revenue", &DailySalesRow::revenue>>;
+
+struct StatusSalesRow {
+    std::string_view status;
+    std::int64_t orders;
+    double revenue;
+};
+
+using StatusSalesMapper = dbr::db::RowMapper<StatusSalesRow,
+    dbr::db::Field<"status", &StatusSalesRow::status>,
+    dbr::db::Field<"orders", &StatusSalesRow::orders>,
+    dbr::db::Field<"revenue", &StatusSalesRow::revenue>>;
+
+struct SpeciesSalesRow {
+    std::string_view species;
+    std::int64_t units;
+    double revenue;
+};
+
+using SpeciesSalesMapper = dbr::db::RowMapper<SpeciesSalesRow,
+    dbr::db::Field<"species", &SpeciesSalesRow::species>,
+    dbr::db::Field<"units", &SpeciesSalesRow::units>,
+    dbr::db::Field<"revenue", &SpeciesSalesRow::revenue>>;
+
+struct CategorySalesRow {
+    std::int64_t id;
+    std::string_view name;
+    std::int64_t units;
+    double revenue;
+};
+
+using CategorySalesMapper = dbr::db::RowMapper<CategorySalesRow,
+    dbr::db::Field<"id", &CategorySalesRow::id>,
+    dbr::db::Field<"name", &CategorySalesRow::name>,
+    dbr::db::Field<"units", &CategorySalesRow::units>,
+    dbr::db::Field<"revenue", &CategorySalesRow::revenue>>;
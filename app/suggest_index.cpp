@@ -0,0 +1,139 @@
+#include "suggest_index.hpp"
+#include "engine/json_writer.hpp"
+
+#include <algorithm>
+#include <queue>
+
+namespace {
+
+constexpr std::uint32_t no_key = UINT32_MAX;
+
+char lower(char c) {
+    return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+bool word_start(std::string_view text, std::size_t i) {
+    auto separator = [](char c) { return c == ' ' || c == '-' || c == '\'' || c == '/'; };
+    return !separator(text[i]) && (i == 0 || separator(text[i - 1]));
+}
+
+const char* kind_name(SuggestIndex::Kind kind) {
+    switch (kind) {
+        case SuggestIndex::Kind::Name: return "name";
+        case SuggestIndex::Kind::Breed: return "breed";
+        case SuggestIndex::Kind::Species: return "species";
+    }
+    return "";
+}
+
+} // namespace
+
+void SuggestIndex::add(std::string_view text, Kind kind) {
+    if (text.empty()) {
+        return;
+    }
+    std::string id(1, static_cast<char>(kind));
+    id += text;
+    auto [it, added] = ids_.try_emplace(std::move(id), static_cast<std::uint32_t>(suggestions_.size()));
+    if (added) {
+        suggestions_.push_back({std::string(text), kind});
+    }
+    ++suggestions_[it->second].weight;
+}
+
+void SuggestIndex::finish() {
+    ids_ = {};
+    for (std::uint32_t s = 0; s < suggestions_.size(); ++s) {
+        auto& text = suggestions_[s].text;
+        auto base = static_cast<std::uint32_t>(key_text_.size());
+        for (char c : text) {
+            key_text_ += lower(c);
+        }
+        for (std::size_t i = 0; i < text.size(); ++i) {
+            if (word_start(text, i)) {
+                keys_.push_back({base + static_cast<std::uint32_t>(i),
+                                 static_cast<std::uint32_t>(text.size() - i), s});
+            }
+        }
+    }
+    std::sort(keys_.begin(), keys_.end(), [&](const Key& a, const Key& b) {
+        return std::string_view(key_text_).substr(a.offset, a.length)
+             < std::string_view(key_text_).substr(b.offset, b.length);
+    });
+
+    leaves_ = 1;
+    while (leaves_ < keys_.size()) leaves_ *= 2;
+    tree_.assign(2 * leaves_, no_key);
+    for (std::size_t i = 0; i < keys_.size(); ++i) {
+        tree_[leaves_ + i] = static_cast<std::uint32_t>(i);
+    }
+    for (std::size_t node = leaves_ - 1; node > 0; --node) {
+        tree_[node] = heavier(tree_[2 * node], tree_[2 * node + 1]);
+    }
+}
+
+std::uint32_t SuggestIndex::heavier(std::uint32_t a, std::uint32_t b) const {
+    if (a == no_key) return b;
+    if (b == no_key) return a;
+    auto wa = weight(a), wb = weight(b);
+    return wb > wa || (wb == wa && b < a) ? b : a;
+}
+
+void SuggestIndex::top(std::string_view prefix, std::size_t k, std::string& out) const {
+    std::string wanted;
+    for (char c : prefix) {
+        wanted += lower(c);
+    }
+    auto first = std::lower_bound(keys_.begin(), keys_.end(), wanted, [&](const Key& key, const std::string& p) {
+        return std::string_view(key_text_).substr(key.offset, key.length) < p;
+    });
+    auto last = std::upper_bound(first, keys_.end(), wanted, [&](const std::string& p, const Key& key) {
+        return p < std::string_view(key_text_).substr(key.offset, std::min<std::size_t>(key.length, p.size()));
+    });
+
+    // Tree nodes exactly covering [first, last), heaviest on top; a popped
+    // inner node is replaced by its two children
+    auto lighter = [&](std::size_t a, std::size_t b) {
+        return heavier(tree_[a], tree_[b]) != tree_[a];
+    };
+    std::priority_queue<std::size_t, std::vector<std::size_t>, decltype(lighter)> nodes(lighter);
+    if (first != last) {
+        std::size_t lo = leaves_ + static_cast<std::size_t>(first - keys_.begin());
+        std::size_t hi = leaves_ + static_cast<std::size_t>(last - keys_.begin());
+        for (; lo < hi; lo /= 2, hi /= 2) {
+            if (lo & 1) nodes.push(lo++);
+            if (hi & 1) nodes.push(--hi);
+        }
+    }
+
+    out += '[';
+    std::vector<std::uint32_t> seen;
+    while (!nodes.empty() && seen.size() < k) {
+        std::size_t node = nodes.top();
+        nodes.pop();
+        if (node < leaves_) {
+            nodes.push(2 * node);
+            nodes.push(2 * node + 1);
+            continue;
+        }
+        if (tree_[node] == no_key) {
+            continue;
+        }
+        // A value can match through more than one of its words
+        auto id = keys_[tree_[node]].suggestion;
+        if (std::find(seen.begin(), seen.end(), id) != seen.end()) {
+            continue;
+        }
+        seen.push_back(id);
+        auto& s = suggestions_[id];
+        if (seen.size() > 1) out += ',';
+        out += "{\"text\":";
+        dbr::json_writer::append_string(out, s.text);
+        out += ",\"kind\":\"";
+        out += kind_name(s.kind);
+        out += "\",\"weight\":";
+        dbr::json_writer::append_number(out, s.weight);
+        out += '}';
+    }
+    out += ']';
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Prefix index behind /api/suggest: the names, breeds and species of the
+// available pets, each weighted by the number of pets that carry it.
+//
+// A value is indexed under its lowercased text and under each of its later
+// words ("golden retriever", "retriever"), so completions match any word
+// start. The keys are slices of one shared text buffer, kept in a sorted
+// array; a prefix selects a contiguous range of it. A segment tree holding
+// the heaviest key of every node's span then yields the top k of that range
+// in O(k log n), however many keys the prefix matches. Built once per
+// catalog snapshot and immutable afterwards.
+class SuggestIndex {
+public:
+    enum class Kind : std::uint8_t { Name, Breed, Species };
+
+    // Counts one pet carrying `text`; empty values are ignored
+    void add(std::string_view text, Kind kind);
+
+    // Builds the key array and tree; call after the last add()
+    void finish();
+
+    // Appends a JSON array of up to `k` suggestions whose text has a word
+    // starting with `prefix` (ASCII case-insensitive), heaviest first
+    void top(std::string_view prefix, std::size_t k, std::string& out) const;
+
+    std::size_t size() const { return suggestions_.size(); }
+
+private:
+    struct Suggestion {
+        std::string text;
+        Kind kind;
+        std::uint32_t weight = 0;
+    };
+    struct Key {
+        std::uint32_t offset;       // into key_text_
+        std::uint32_t length;
+        std::uint32_t suggestion;
+    };
+
+    std::uint32_t weight(std::uint32_t pos) const { return suggestions_[keys_[pos].suggestion].weight; }
+    // Key position in `a` or `b` that ranks first: heavier, then earlier in
+    // key order (no_key ranks last)
+    std::uint32_t heavier(std::uint32_t a, std::uint32_t b) const;
+
+    std::unordered_map<std::string, std::uint32_t> ids_;   // kind + text; build time only
+    std::vector<Suggestion> suggestions_;
+    std::string key_text_;
+    std::vector<Key> keys_;                 // sorted by key text
+    std::size_t leaves_ = 0;
+    std::vector<std::uint32_t> tree_;       // heaviest key position per node
+};